@@ -128,6 +128,7 @@ int boot_arm_linux(void *fdt, FitImageNode *kernel)
 		return 1;
 
 	size_t true_size = kernel->size;
+	timestamp_add_now(TS_KERNEL_DECOMPRESS);
 	switch (kernel->compression) {
 	case CompressionNone:
 		if (kernel->size > MAX_KERNEL_SIZE) {
@@ -158,6 +159,7 @@ int boot_arm_linux(void *fdt, FitImageNode *kernel)
 	default: // It's 2015 and GCC's reachability analyzer still sucks...
 		return 1;
 	}
+	timestamp_add_now(TS_KERNEL_DECOMPRESS_DONE);
 
 	printf("jumping to kernel\n");
 
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/boot_perf.h"
+#include "base/cleanup_funcs.h"
+#include "base/init_funcs.h"
+#include "base/timestamp.h"
+
+static const struct {
+	enum timestamp_id start;
+	enum timestamp_id end;
+} boot_perf_phases[] = {
+	{ TS_RO_VB_SELECT_FIRMWARE, TS_RO_VB_SELECT_FIRMWARE_DONE },
+	{ TS_RO_RW_DECOMPRESS, TS_RO_RW_DECOMPRESS_DONE },
+	{ TS_INIT_FUNCS, TS_INIT_FUNCS_DONE },
+	{ TS_VB_SELECT_AND_LOAD_KERNEL, TS_VB_SELECT_AND_LOAD_KERNEL_DONE },
+	{ TS_VB_EC_UPDATE, TS_VB_EC_UPDATE_DONE },
+	{ TS_STORAGE_UPDATE, TS_STORAGE_UPDATE_DONE },
+	{ TS_KERNEL_READ, TS_KERNEL_READ_DONE },
+	{ TS_TPM_OPEN, TS_TPM_CLOSE },
+	{ TS_DISPLAY_INIT, TS_DISPLAY_INIT_DONE },
+};
+
+static uint64_t counters[BootPerfCounterEnd - BootPerfCounterFirst];
+static const char *boot_device;
+
+#define COUNTER(id) counters[(id) - BootPerfCounterFirst]
+
+void boot_perf_add(BootPerfCounter counter, uint64_t value)
+{
+	COUNTER(counter) += value;
+}
+
+void boot_perf_set_device(const char *name)
+{
+	boot_device = name;
+}
+
+static int boot_perf_phase_us(enum timestamp_id start, enum timestamp_id end,
+			      uint64_t *us)
+{
+	uint64_t start_us, end_us;
+
+	if (timestamp_find_us(start, &start_us) ||
+	    timestamp_find_us(end, &end_us) || end_us < start_us)
+		return 1;
+	*us = end_us - start_us;
+	return 0;
+}
+
+static uint64_t boot_perf_kibps(uint64_t bytes, uint64_t us)
+{
+	return us ? bytes * 1000000 / 1024 / us : 0;
+}
+
+// Work out the counters which come from the others and the timestamps.
+static void boot_perf_derive(void)
+{
+	uint64_t start_us;
+
+	COUNTER(BootPerfTotalUs) = timestamp_now_us();
+	if (!timestamp_find_us(TS_START, &start_us))
+		COUNTER(BootPerfDepthchargeUs) =
+			COUNTER(BootPerfTotalUs) - start_us;
+
+	uint64_t bytes = COUNTER(BootPerfKernelReadBytes);
+	uint64_t read_us = COUNTER(BootPerfKernelReadUs);
+	COUNTER(BootPerfKernelReadKiBps) = boot_perf_kibps(bytes, read_us);
+
+	uint64_t stream_us = COUNTER(BootPerfKernelStreamUs);
+	if (stream_us > read_us) {
+		COUNTER(BootPerfKernelVerifyUs) = stream_us - read_us;
+		COUNTER(BootPerfKernelVerifyKiBps) =
+			boot_perf_kibps(bytes, stream_us - read_us);
+	}
+}
+
+/*
+ * Phases which didn't happen and counters which are zero are left out, so
+ * readers should treat a missing counter as zero.
+ */
+static BootPerfHeader *boot_perf_build(size_t *size)
+{
+	boot_perf_derive();
+
+	size_t max_size = sizeof(BootPerfHeader) + sizeof(BootPerfEntry) *
+		(ARRAY_SIZE(boot_perf_phases) + ARRAY_SIZE(counters));
+	BootPerfHeader *header = xzalloc(max_size);
+	BootPerfEntry *entries = (BootPerfEntry *)(header + 1);
+
+	header->magic = BootPerfMagic;
+	header->version = BootPerfVersion;
+	header->entry_size = sizeof(BootPerfEntry);
+
+	for (int i = 0; i < ARRAY_SIZE(boot_perf_phases); i++) {
+		uint64_t us;
+		if (boot_perf_phase_us(boot_perf_phases[i].start,
+				       boot_perf_phases[i].end, &us))
+			continue;
+		entries[header->num_entries].id = boot_perf_phases[i].start;
+		entries[header->num_entries++].value = us;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(counters); i++) {
+		if (!counters[i])
+			continue;
+		entries[header->num_entries].id = BootPerfCounterFirst + i;
+		entries[header->num_entries++].value = counters[i];
+	}
+
+	*size = sizeof(*header) + sizeof(*entries) * header->num_entries;
+	return header;
+}
+
+void boot_perf_add_dt_props(DeviceTreeNode *node)
+{
+	size_t size;
+	BootPerfHeader *record = boot_perf_build(&size);
+
+	dt_add_bin_prop(node, "boot-performance", record, size);
+	if (boot_device)
+		dt_add_string_prop(node, "boot-performance-device",
+				   (char *)boot_device);
+}
+
+/*
+ * The same record goes to the console, which is all there is on boards
+ * without a device tree, and "cbmem -c" can read back from the OS.
+ */
+static int boot_perf_cleanup(CleanupFunc *cleanup, CleanupType type)
+{
+	size_t size;
+	BootPerfHeader *record = boot_perf_build(&size);
+	BootPerfEntry *entries = (BootPerfEntry *)(record + 1);
+
+	printf("boot-perf: version %d device %s\n", record->version,
+	       boot_device ? boot_device : "none");
+	for (int i = 0; i < record->num_entries; i++) {
+		const char *name = timestamp_name(entries[i].id);
+		printf("boot-perf: %u %llu%s%s\n", entries[i].id,
+		       (unsigned long long)entries[i].value,
+		       name ? " " : "", name ? name : "");
+	}
+	printf("boot-perf: end\n");
+
+	free(record);
+	return 0;
+}
+
+static CleanupFunc boot_perf_cleanup_func = {
+	&boot_perf_cleanup,
+	CleanupOnHandoff | CleanupOnLegacy,
+	NULL
+};
+
+static int boot_perf_install_cleanup(void)
+{
+	list_insert_after(&boot_perf_cleanup_func.list_node, &cleanup_funcs);
+	return 0;
+}
+
+INIT_FUNC(boot_perf_install_cleanup);
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __BASE_BOOT_PERF_H__
+#define __BASE_BOOT_PERF_H__
+
+#include <stdint.h>
+
+#include "base/device_tree.h"
+
+/*
+ * The boot performance record handed to the OS is a BootPerfHeader followed
+ * by num_entries BootPerfEntry structures, all in the firmware's (little
+ * endian) byte order. Entry IDs never change meaning, and readers should
+ * skip any they don't know.
+ *
+ * IDs from the timestamp_id range are phases, with the time in microseconds
+ * from that timestamp to its matching _DONE timestamp. IDs from the range
+ * below are counters.
+ */
+enum {
+	BootPerfMagic = 0x46524250,	// "PBRF"
+	BootPerfVersion = 1
+};
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t entry_size;
+	uint32_t num_entries;
+	uint32_t reserved;
+} __attribute__((packed)) BootPerfHeader;
+
+typedef struct {
+	uint32_t id;
+	uint32_t reserved;
+	uint64_t value;
+} __attribute__((packed)) BootPerfEntry;
+
+typedef enum {
+	BootPerfCounterFirst = 2000,
+
+	// Microseconds from the start of the timestamp table to the report.
+	BootPerfTotalUs = BootPerfCounterFirst,
+	// Microseconds from depthcharge's entry to the report.
+	BootPerfDepthchargeUs = 2001,
+
+	// Reads vboot made through the disk callbacks, other than the kernel.
+	BootPerfDiskReadBytes = 2010,
+	BootPerfDiskReadUs = 2011,
+	// Kernel reads through the streaming callbacks, and their throughput.
+	BootPerfKernelReadBytes = 2012,
+	BootPerfKernelReadUs = 2013,
+	BootPerfKernelReadKiBps = 2014,
+	/*
+	 * Time the kernel stream was open but not being read from, which is
+	 * mostly vboot hashing and checking it, and the rate that implies.
+	 */
+	BootPerfKernelVerifyUs = 2015,
+	BootPerfKernelVerifyKiBps = 2016,
+	// Time kernel streams were open, summed over every partition tried.
+	BootPerfKernelStreamUs = 2019,
+	// Commands storage drivers had to send again after they failed.
+	BootPerfStorageRetries = 2017,
+	// Bytes storage drivers had to copy through bounce buffers.
+	BootPerfBounceBytes = 2018,
+
+	BootPerfTpmCommands = 2020,
+	BootPerfTpmErrors = 2021,
+	BootPerfTpmUs = 2022,
+
+	BootPerfCounterEnd
+} BootPerfCounter;
+
+void boot_perf_add(BootPerfCounter counter, uint64_t value);
+
+// Note which device the kernel is being loaded from. name isn't copied.
+void boot_perf_set_device(const char *name);
+
+/*
+ * Add the record to node as a "boot-performance" property, along with the
+ * name of the boot device if there is one.
+ */
+void boot_perf_add_dt_props(DeviceTreeNode *node);
+
+#endif /* __BASE_BOOT_PERF_H__ */
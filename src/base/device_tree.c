@@ -26,6 +26,7 @@
 #include <stdint.h>
 
 #include "base/device_tree.h"
+#include "base/timestamp.h"
 
 /*
  * Functions for picking apart flattened trees.
@@ -867,11 +868,13 @@ ListNode device_tree_fixups;
 int dt_apply_fixups(DeviceTree *tree)
 {
 	DeviceTreeFixup *fixup;
+	timestamp_add_now(TS_DT_FIXUPS);
 	list_for_each(fixup, device_tree_fixups, list_node) {
 		assert(fixup->fixup);
 		if (fixup->fixup(fixup, tree))
 			return 1;
 	}
+	timestamp_add_now(TS_DT_FIXUPS_DONE);
 	return 0;
 }
 
@@ -20,17 +20,105 @@
  * MA 02111-1307 USA
  */
 
+#include <libpayload.h>
+
 #include "base/init_funcs.h"
+#include "base/timestamp.h"
 #include "image/symbols.h"
 
-int run_init_funcs(void)
+enum {
+	// Init funcs that take longer than this get their own timestamps.
+	InitFuncSlowUs = 1000
+};
+
+static InitFunc *init_funcs_start(void)
+{
+	return (InitFunc *)&_init_funcs_start;
+}
+
+int init_func_count(void)
+{
+	return (InitFunc *)&_init_funcs_end - init_funcs_start();
+}
+
+InitFunc *init_func_get(int index)
+{
+	if (index < 0 || index >= init_func_count())
+		return NULL;
+	return &init_funcs_start()[index];
+}
+
+static InitFunc *init_func_find(const char *name)
+{
+	for (int i = 0; i < init_func_count(); i++) {
+		InitFunc *init_func = init_func_get(i);
+		if (!strcmp(init_func->name, name))
+			return init_func;
+	}
+	return NULL;
+}
+
+static int run_init_func(InitFunc *init_func)
+{
+	switch (init_func->state) {
+	case InitFuncDone:
+		return 0;
+	case InitFuncFailed:
+		return 1;
+	case InitFuncRunning:
+		printf("Init func %s depends on itself.\n", init_func->name);
+		return 1;
+	case InitFuncPending:
+		break;
+	}
+
+	init_func->state = InitFuncRunning;
+
+	int res = 0;
+	for (const char * const *dep = init_func->deps; dep && *dep; dep++) {
+		InitFunc *dep_func = init_func_find(*dep);
+		if (dep_func)
+			res = run_init_func(dep_func) || res;
+	}
+
+	uint64_t start = timer_us(0);
+	res = init_func->func() || res;
+	init_func->time_us = timer_us(start);
+	init_func->state = res ? InitFuncFailed : InitFuncDone;
+
+	// The timestamp ID is only meaningful to this image, see timestamp.h.
+	if (init_func->time_us >= InitFuncSlowUs) {
+		int index = init_func - init_funcs_start();
+		if (TS_INIT_FUNC_FIRST + index <= TS_INIT_FUNC_LAST)
+			timestamp_add_now(TS_INIT_FUNC_FIRST + index);
+	}
+
+	return res;
+}
+
+static int run_init_funcs_flagged(uint32_t deferred)
 {
-	init_func_t *start = (init_func_t *)&_init_funcs_start;
-	init_func_t *end = (init_func_t *)&_init_funcs_end;
 	int res = 0;
 
-	for (init_func_t *init_func = start; init_func != end; init_func++)
-		res = (*init_func)() || res;
+	for (int i = 0; i < init_func_count(); i++) {
+		InitFunc *init_func = init_func_get(i);
+		if ((init_func->flags & InitFuncDeferred) == deferred)
+			res = run_init_func(init_func) || res;
+	}
 
 	return res;
 }
+
+int run_init_funcs(void)
+{
+	timestamp_add_now(TS_INIT_FUNCS);
+	int res = run_init_funcs_flagged(0);
+	timestamp_add_now(TS_INIT_FUNCS_DONE);
+
+	return res;
+}
+
+int run_deferred_init_funcs(void)
+{
+	return run_init_funcs_flagged(InitFuncDeferred);
+}
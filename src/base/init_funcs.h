@@ -23,12 +23,65 @@
 #ifndef __BASE_INIT_FUNCS_H__
 #define __BASE_INIT_FUNCS_H__
 
+#include <stdint.h>
+
 typedef int (*init_func_t)(void);
 
-#define INIT_FUNC(func) \
-	init_func_t __init_func_ptr__##func \
-		__attribute__((section(".init_funcs"))) = &func;
+enum {
+	// Only run once something needs it, see run_deferred_init_funcs().
+	InitFuncDeferred = 1 << 0
+};
+
+typedef enum InitFuncState {
+	InitFuncPending = 0,
+	InitFuncRunning,
+	InitFuncDone,
+	InitFuncFailed
+} InitFuncState;
+
+typedef struct InitFunc {
+	init_func_t func;
+	const char *name;
+	// Names of init funcs which have to run first, NULL terminated. Ones
+	// which aren't built in are ignored.
+	const char * const *deps;
+	uint32_t flags;
 
+	InitFuncState state;
+	uint32_t time_us;
+} InitFunc;
+
+/*
+ * The entries are laid out back to back in the .init_funcs section, so they
+ * must not be padded out to anything bigger than their natural alignment.
+ */
+#define INIT_FUNC_ENTRY(func, entry_flags, entry_deps) \
+	InitFunc __init_func__##func \
+		__attribute__((section(".init_funcs"), \
+			       aligned(sizeof(void *)))) = { \
+		&func, #func, entry_deps, entry_flags \
+	};
+
+#define INIT_FUNC(func) INIT_FUNC_ENTRY(func, 0, NULL)
+
+// For init funcs nothing needs until the kernel is about to boot or the UI
+// comes up.
+#define INIT_FUNC_DEFERRED(func) INIT_FUNC_ENTRY(func, InitFuncDeferred, NULL)
+
+// Run func after the init funcs named in the remaining arguments.
+#define INIT_FUNC_AFTER(func, ...) \
+	static const char * const __init_func_deps__##func[] = { \
+		__VA_ARGS__, NULL \
+	}; \
+	INIT_FUNC_ENTRY(func, 0, __init_func_deps__##func)
+
+// Run everything that isn't deferred, each after its dependencies.
 int run_init_funcs(void);
+// Run the deferred init funcs that haven't run yet. Safe to call repeatedly.
+int run_deferred_init_funcs(void);
+
+// Look up init funcs, for example to report how long they took.
+int init_func_count(void);
+InitFunc *init_func_get(int index);
 
 #endif /* __BASE_INIT_FUNCS_H__ */
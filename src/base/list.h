@@ -40,9 +40,11 @@ void list_insert_after(ListNode *node, ListNode *after);
 // Insert ListNode node before ListNode before in a doubly linked list.
 void list_insert_before(ListNode *node, ListNode *before);
 
+// The end is a NULL member, checked as an integer since compilers may assume
+// &ptr->member is never NULL.
 #define list_for_each(ptr, head, member)                                \
 	for ((ptr) = container_of((head).next, typeof(*(ptr)), member); \
-		&((ptr)->member);                                       \
+		(uintptr_t)(ptr) + offsetof(typeof(*(ptr)), member);    \
 		(ptr) = container_of((ptr)->member.next,                \
 			typeof(*(ptr)), member))
 
@@ -19,6 +19,7 @@
 #include <libpayload.h>
 #include <stdint.h>
 
+#include "base/init_funcs.h"
 #include "base/timestamp.h"
 
 struct timestamp_entry {
@@ -35,6 +36,59 @@ struct timestamp_table {
 
 static struct timestamp_table *ts_table;
 
+static const struct {
+	enum timestamp_id id;
+	const char *name;
+} timestamp_names[] = {
+	{ TS_START, "start of depthcharge" },
+	{ TS_RO_PARAMS_INIT, "RO parameter init" },
+	{ TS_RO_VB_INIT, "RO vboot init" },
+	{ TS_RO_VB_SELECT_FIRMWARE, "RO vboot select firmware" },
+	{ TS_RO_VB_SELECT_AND_LOAD_KERNEL, "RO vboot select&load kernel" },
+	{ TS_RO_VB_SELECT_FIRMWARE_DONE, "RO vboot firmware selected" },
+	{ TS_RO_RW_DECOMPRESS, "RO decompressing RW firmware" },
+	{ TS_RO_RW_DECOMPRESS_DONE, "RO finished decompressing RW firmware" },
+	{ TS_RW_VB_SELECT_AND_LOAD_KERNEL, "RW vboot select&load kernel" },
+	{ TS_VB_SELECT_AND_LOAD_KERNEL, "vboot select&load kernel" },
+	{ TS_VB_SELECT_AND_LOAD_KERNEL_DONE, "vboot kernel loaded" },
+	{ TS_VB_EC_VBOOT_DONE, "finished EC verification" },
+	{ TS_VB_EC_HASH_READ, "read EC RW hash" },
+	{ TS_VB_EC_UPDATE, "updating EC RW" },
+	{ TS_VB_EC_UPDATE_DONE, "finished updating EC RW" },
+	{ TS_VB_EC_JUMP_TO_RW, "jumping EC to RW" },
+	{ TS_VB_EC_PROTECT, "protecting EC RW" },
+	{ TS_INIT_FUNCS, "running init funcs" },
+	{ TS_INIT_FUNCS_DONE, "finished init funcs" },
+	{ TS_STORAGE_UPDATE, "updating storage controllers" },
+	{ TS_STORAGE_UPDATE_DONE, "finished updating storage controllers" },
+	{ TS_KERNEL_READ, "reading kernel" },
+	{ TS_KERNEL_READ_DONE, "finished reading kernel" },
+	{ TS_TPM_OPEN, "TPM opened" },
+	{ TS_TPM_CLOSE, "TPM closed" },
+	{ TS_DISPLAY_INIT, "initializing display" },
+	{ TS_DISPLAY_INIT_DONE, "finished initializing display" },
+	{ TS_CROSSYSTEM_DATA, "crossystem data" },
+	{ TS_START_KERNEL, "start kernel" },
+	{ TS_DT_FIXUPS, "applying device tree fixups" },
+	{ TS_DT_FIXUPS_DONE, "finished applying device tree fixups" },
+	{ TS_KERNEL_DECOMPRESS, "decompressing kernel" },
+	{ TS_KERNEL_DECOMPRESS_DONE, "finished decompressing kernel" },
+};
+
+const char *timestamp_name(uint32_t id)
+{
+	if (id >= TS_INIT_FUNC_FIRST && id <= TS_INIT_FUNC_LAST) {
+		InitFunc *init_func = init_func_get(id - TS_INIT_FUNC_FIRST);
+		return init_func ? init_func->name : NULL;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(timestamp_names); i++) {
+		if (timestamp_names[i].id == id)
+			return timestamp_names[i].name;
+	}
+	return NULL;
+}
+
 void timestamp_init(void)
 {
 	ts_table = lib_sysinfo.tstamp_table;
@@ -60,3 +114,33 @@ void timestamp_add_now(enum timestamp_id id)
 	else
 		timestamp_add(id, timer_us(0));
 }
+
+static uint64_t timestamp_to_us(uint64_t stamp)
+{
+	if (CONFIG_TIMESTAMP_RAW)
+		return stamp * 1000000 / timer_hz();
+	return stamp;
+}
+
+int timestamp_find_us(enum timestamp_id id, uint64_t *us)
+{
+	if (!ts_table)
+		return 1;
+
+	for (int i = ts_table->num_entries - 1; i >= 0; i--) {
+		if (ts_table->entries[i].entry_id == id) {
+			*us = timestamp_to_us(ts_table->entries[i].entry_stamp);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+uint64_t timestamp_now_us(void)
+{
+	uint64_t base = ts_table ? ts_table->base_time : 0;
+
+	if (CONFIG_TIMESTAMP_RAW)
+		return timestamp_to_us(timer_raw_value() - base);
+	return timer_us(0) - base;
+}
@@ -20,6 +20,11 @@
 
 #include <stdint.h>
 
+/*
+ * Most IDs mark the start of the phase they're named after, and a matching
+ * _DONE ID marks its end. Add a name to the table in timestamp.c for every
+ * new ID.
+ */
 enum timestamp_id {
 	// Depthcharge entry IDs start at 1000.
 	TS_START = 1000,
@@ -28,19 +33,68 @@ enum timestamp_id {
 	TS_RO_VB_INIT = 1002,
 	TS_RO_VB_SELECT_FIRMWARE = 1003,
 	TS_RO_VB_SELECT_AND_LOAD_KERNEL = 1004,
+	TS_RO_VB_SELECT_FIRMWARE_DONE = 1005,
+	TS_RO_RW_DECOMPRESS = 1006,
+	TS_RO_RW_DECOMPRESS_DONE = 1007,
 
 	TS_RW_VB_SELECT_AND_LOAD_KERNEL = 1010,
 
 	TS_VB_SELECT_AND_LOAD_KERNEL = 1020,
+	// The kernel has been loaded and its hash checked.
+	TS_VB_SELECT_AND_LOAD_KERNEL_DONE = 1021,
 
 	TS_VB_EC_VBOOT_DONE = 1030,
+	TS_VB_EC_HASH_READ = 1031,
+	TS_VB_EC_UPDATE = 1032,
+	TS_VB_EC_UPDATE_DONE = 1033,
+	TS_VB_EC_JUMP_TO_RW = 1034,
+	TS_VB_EC_PROTECT = 1035,
+
+	TS_INIT_FUNCS = 1040,
+	TS_INIT_FUNCS_DONE = 1041,
+
+	TS_STORAGE_UPDATE = 1050,
+	TS_STORAGE_UPDATE_DONE = 1051,
+	// Opening the stream means the GPT has been read and checked.
+	TS_KERNEL_READ = 1052,
+	TS_KERNEL_READ_DONE = 1053,
+
+	TS_TPM_OPEN = 1060,
+	TS_TPM_CLOSE = 1061,
+
+	TS_DISPLAY_INIT = 1070,
+	TS_DISPLAY_INIT_DONE = 1071,
 
 	TS_CROSSYSTEM_DATA = 1100,
-	TS_START_KERNEL = 1101
+	TS_START_KERNEL = 1101,
+	TS_DT_FIXUPS = 1102,
+	TS_DT_FIXUPS_DONE = 1103,
+	TS_KERNEL_DECOMPRESS = 1104,
+	TS_KERNEL_DECOMPRESS_DONE = 1105,
+
+	/*
+	 * Marks the end of each slow init func, by its index in the image's
+	 * .init_funcs section. That depends on link order, so the same ID
+	 * names a different function in each build and board. Only
+	 * timestamp_name() in the same image can map it back to a name.
+	 */
+	TS_INIT_FUNC_FIRST = 1200,
+	TS_INIT_FUNC_LAST = 1299
 };
 
 void timestamp_init(void);
 void timestamp_add(enum timestamp_id id, uint64_t ts_time);
 void timestamp_add_now(enum timestamp_id id);
 
+/*
+ * The time in microseconds from the start of the table to the most recent
+ * entry for id. Returns non-zero if there's no such entry.
+ */
+int timestamp_find_us(enum timestamp_id id, uint64_t *us);
+// The time in microseconds from the start of the table until now.
+uint64_t timestamp_now_us(void);
+
+// A short description of id, or NULL if it isn't one of ours.
+const char *timestamp_name(uint32_t id);
+
 #endif /* __BASE_TIMESTAMP_H__ */
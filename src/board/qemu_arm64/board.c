@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but without any warranty; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include "base/init_funcs.h"
+#include "base/list.h"
+#include "drivers/bus/virtio/mmio.h"
+#include "drivers/flash/flash.h"
+#include "drivers/flash/memmapped.h"
+#include "drivers/gpio/gpio.h"
+#include "drivers/power/psci.h"
+#include "drivers/storage/blockdev.h"
+#include "drivers/storage/virtio_blk.h"
+#include "drivers/tpm/lpc.h"
+#include "drivers/tpm/tpm.h"
+#include "vboot/util/flag.h"
+
+/*
+ * The virt machine with secure=on: the coreboot image is in the first pflash
+ * bank at address 0 and PSCI is provided by the secure monitor. A TPM can be
+ * attached with "-device tpm-tis-device", which QEMU puts at the start of the
+ * platform bus. Disks and NICs are virtio devices on the virtio-mmio transport.
+ */
+
+enum {
+	VirtioMmioBase = 0x0a000000,
+	VirtioMmioStride = 0x200,
+	VirtioMmioSlots = 32
+};
+
+static int board_setup(void)
+{
+	// There are no physical switches, so boot with the lid open and no
+	// write protect. Recovery is requested through NV storage.
+	flag_install(FLAG_WPSW, new_gpio_low());
+	flag_install(FLAG_RECSW, new_gpio_low());
+	flag_install(FLAG_LIDSW, new_gpio_high());
+	flag_install(FLAG_PWRSW, new_gpio_low());
+
+	flash_set_ops(&new_mem_mapped_flash(0x00000000, 0x1000000)->ops);
+
+	power_set_ops(&psci_power_ops);
+
+	for (int i = 0; i < VirtioMmioSlots; i++) {
+		uintptr_t base = VirtioMmioBase + i * VirtioMmioStride;
+		uint32_t id = virtio_mmio_device_id(base);
+		if (id != VirtioIdBlock && id != VirtioIdNet)
+			continue;
+
+		VirtioMmio *virtio = new_virtio_mmio(base);
+		if (id == VirtioIdNet) {
+			list_insert_after(&virtio->ops.list_node,
+					  &virtio_devices);
+			continue;
+		}
+		VirtioBlkCtrlr *blk = new_virtio_blk_ctrlr(&virtio->ops);
+		list_insert_after(&blk->ctrlr.list_node,
+				  &fixed_block_dev_controllers);
+	}
+
+	tpm_set_ops(&new_lpc_tpm((void *)(uintptr_t)0x0c000000)->ops);
+
+	return 0;
+}
+
+INIT_FUNC(board_setup);
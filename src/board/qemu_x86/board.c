@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but without any warranty; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <pci.h>
+
+#include "base/init_funcs.h"
+#include "base/list.h"
+#include "drivers/bus/virtio/pci.h"
+#include "drivers/flash/flash.h"
+#include "drivers/flash/memmapped.h"
+#include "drivers/gpio/gpio.h"
+#include "drivers/power/pch.h"
+#include "drivers/storage/ahci.h"
+#include "drivers/storage/blockdev.h"
+#include "drivers/storage/nvme.h"
+#include "drivers/storage/sdhci.h"
+#include "drivers/storage/virtio_blk.h"
+#include "drivers/tpm/lpc.h"
+#include "drivers/tpm/tpm.h"
+#include "vboot/util/flag.h"
+
+/*
+ * The q35 machine: the coreboot image is mapped as pflash right below 4G,
+ * the ICH9 AHCI controller is always at 0:1f.2 and a TPM can be attached
+ * with "-device tpm-tis" in front of swtpm. NVMe, SDHCI and virtio devices
+ * land on whatever slot QEMU picks, so they're found by class code or ID.
+ * USB controllers are picked up from PCI by libpayload.
+ */
+
+enum {
+	PciClassStorageSata = 0x0106,
+	PciClassStorageNvm = 0x0108,
+	PciClassSystemSdhci = 0x0805
+};
+
+static const int sd_clock_min = 400 * 1000;
+static const int sd_clock_max = 52 * 1000 * 1000;
+
+static void add_pci_device(pcidev_t dev)
+{
+	switch (virtio_legacy_pci_device_id(dev)) {
+	case VirtioIdBlock: {
+		VirtioLegacyPci *virtio = new_virtio_legacy_pci(dev);
+		VirtioBlkCtrlr *blk = new_virtio_blk_ctrlr(&virtio->ops);
+		list_insert_after(&blk->ctrlr.list_node,
+				  &fixed_block_dev_controllers);
+		return;
+	}
+	case VirtioIdNet: {
+		VirtioLegacyPci *virtio = new_virtio_legacy_pci(dev);
+		list_insert_after(&virtio->ops.list_node, &virtio_devices);
+		return;
+	}
+	}
+
+	uint16_t class = pci_read_config16(dev, REG_SUBCLASS);
+
+	switch (class) {
+	case PciClassStorageSata: {
+		AhciCtrlr *ahci = new_ahci_ctrlr(dev);
+		list_insert_after(&ahci->ctrlr.list_node,
+				  &fixed_block_dev_controllers);
+		break;
+	}
+	case PciClassStorageNvm: {
+		NvmeCtrlr *nvme = new_nvme_ctrlr(dev);
+		list_insert_after(&nvme->ctrlr.list_node,
+				  &fixed_block_dev_controllers);
+		break;
+	}
+	case PciClassSystemSdhci: {
+		SdhciHost *sd = new_pci_sdhci_host(dev,
+				SDHCI_PLATFORM_REMOVABLE,
+				sd_clock_min, sd_clock_max);
+		list_insert_after(&sd->mmc_ctrlr.ctrlr.list_node,
+				  &removable_block_dev_controllers);
+		break;
+	}
+	}
+}
+
+static int board_setup(void)
+{
+	// There are no physical switches, so boot with the lid open and no
+	// write protect. Recovery is requested through NV storage.
+	flag_install(FLAG_WPSW, new_gpio_low());
+	flag_install(FLAG_RECSW, new_gpio_low());
+	flag_install(FLAG_LIDSW, new_gpio_high());
+	flag_install(FLAG_PWRSW, new_gpio_low());
+
+	flash_set_ops(&new_mem_mapped_flash(0xff800000, 0x800000)->ops);
+
+	for (int slot = 0; slot < 0x20; slot++) {
+		for (int func = 0; func < 8; func++) {
+			pcidev_t dev = PCI_DEV(0, slot, func);
+			uint32_t ids = pci_read_config32(dev, REG_VENDOR_ID);
+
+			if (ids == 0xffffffff || ids == 0x00000000)
+				continue;
+			add_pci_device(dev);
+		}
+	}
+
+	power_set_ops(&qemu_q35_power_ops);
+
+	tpm_set_ops(&new_lpc_tpm((void *)(uintptr_t)0xfed40000)->ops);
+
+	return 0;
+}
+
+INIT_FUNC(board_setup);
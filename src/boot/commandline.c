@@ -100,7 +100,7 @@ int commandline_subst(const char *src, char *dest, size_t dest_size,
 	}
 
 	// Prepend "cros_secure " to the command line.
-	CHECK_SPACE(cros_secure_size);
+	CHECK_SPACE(cros_secure_size + 1);
 	memcpy(dest, cros_secure, cros_secure_size);
 	dest += (cros_secure_size);
 
@@ -109,7 +109,7 @@ int commandline_subst(const char *src, char *dest, size_t dest_size,
 	if (mainboard_cmdline != NULL) {
 		size_t mainboard_cmdline_size = strlen(mainboard_cmdline);
 		if (mainboard_cmdline_size > 0) {
-			CHECK_SPACE(mainboard_cmdline_size)
+			CHECK_SPACE(mainboard_cmdline_size + 1)
 			memcpy(dest, mainboard_cmdline, mainboard_cmdline_size);
 			dest += mainboard_cmdline_size;
 		}
@@ -344,6 +344,10 @@ FitImageNode *fit_load(void *fit, char *cmd_line, DeviceTree **dt)
 
 	DeviceTree *tree = fdt_unflatten(fit);
 
+	// Forget the nodes from any earlier FIT.
+	image_nodes.next = NULL;
+	config_nodes.next = NULL;
+
 	const char *default_config_name = NULL;
 	FitConfigNode *default_config = NULL;
 	FitConfigNode *compat_config = NULL;
@@ -7,11 +7,13 @@
 #include "common.h"
 #include <cbfs.h>
 
+#include "drivers/flash/cbfs.h"
+
 static int do_cbfs_dump(char * const name)
 {
 	struct cbfs_file *file;
 
-	file = cbfs_get_file(CBFS_DEFAULT_MEDIA, name);
+	file = cbfs_index_get_file(NULL, name);
 	if (file == NULL) {
 		printf("File '%s' not found\n", name);
 		return CMD_RET_FAILURE;
@@ -27,7 +29,10 @@ static int do_cbfs_dump(char * const name)
 
 static int do_cbfs_ls()
 {
-	printf("Command not implemented\n");
+	if (cbfs_index_list(NULL)) {
+		printf("Couldn't read the CBFS\n");
+		return CMD_RET_FAILURE;
+	}
 	return CMD_RET_SUCCESS;
 }
 
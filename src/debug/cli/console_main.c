@@ -21,6 +21,7 @@
  * MA 02111-1307 USA
  */
 
+#include "base/init_funcs.h"
 #include "debug/cli/common.h"
 #include "debug/cli/command.h"
 
@@ -554,6 +555,10 @@ void console_loop(void)
 	int len, flag, rc = 0;
 	char lastcommand[128] = {0};
 
+	// Commands may need anything, deferred or not.
+	if (run_deferred_init_funcs())
+		printf("Deferred init funcs failed.\n");
+
 	/*
 	 * Main Loop for Monitor Command Processing
 	 */
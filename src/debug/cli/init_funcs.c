@@ -0,0 +1,42 @@
+/*
+ * Command for showing how long each init func took.
+ *
+ * Copyright (C) 2016 Chromium OS Authors
+ */
+
+#include "common.h"
+#include "base/init_funcs.h"
+
+static const char * const init_func_states[] = {
+	[InitFuncPending] = "pending",
+	[InitFuncRunning] = "running",
+	[InitFuncDone] = "done",
+	[InitFuncFailed] = "failed",
+};
+
+static int do_initfuncs(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	uint64_t total_us = 0;
+
+	printf("%10s  %-8s %-9s %s\n", "time (us)", "state", "when", "name");
+	for (int i = 0; i < init_func_count(); i++) {
+		InitFunc *init_func = init_func_get(i);
+
+		printf("%10u  %-8s %-9s %s\n", init_func->time_us,
+		       init_func_states[init_func->state],
+		       init_func->flags & InitFuncDeferred ?
+				"deferred" : "early",
+		       init_func->name);
+		total_us += init_func->time_us;
+	}
+	printf("%10llu  total\n", (unsigned long long)total_us);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	   initfuncs,	1,	1,
+	   "show init func timing",
+	   "  - print how long each init func took and whether it has run"
+);
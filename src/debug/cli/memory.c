@@ -21,6 +21,10 @@
  * MA 02111-1307 USA
  */
 
+#include <coreboot_tables.h>
+#include <sysinfo.h>
+
+#include "base/physmem.h"
 #include "debug/cli/common.h"
 
 typedef unsigned long ulong;
@@ -363,6 +367,145 @@ mod_mem(cmd_tbl_t *cmdtp, int incrflag, int flag, int argc, char * const argv[])
 	return 0;
 }
 
+/* Memory bandwidth
+ *
+ * Syntax:
+ *	membench			- heap buffers from L1 to DRAM sizes
+ *	membench fb			- the framebuffer (clobbers it)
+ *	membench phys {addr} {len}	- arch_phys_memset at a physical address
+ */
+enum {
+	MEMBENCH_MIN_SIZE = 4 * 1024,
+	MEMBENCH_MAX_SIZE = 16 * 1024 * 1024,
+	/* Repeat each size until about this much has been moved. */
+	MEMBENCH_BYTES = 64 * 1024 * 1024
+};
+
+static uint64_t membench_mib_per_sec(uint64_t bytes, uint64_t us)
+{
+	return bytes * 1000000 / (1024 * 1024) / (us ? us : 1);
+}
+
+static uint64_t membench_read(const void *buf, size_t size)
+{
+	const volatile uint64_t *p = buf;
+	const volatile uint64_t *end = p + size / sizeof(*p);
+	uint64_t sum = 0;
+
+	while (p < end)
+		sum += *p++;
+	return sum;
+}
+
+/* Time memset, read and, when there's room for a second copy, memcpy. */
+static void membench_region(const char *what, uint8_t *buf, size_t size,
+			    int copy)
+{
+	uint64_t iters = MAX(1, MEMBENCH_BYTES / size);
+	uint64_t bytes = iters * size;
+	uint64_t start, set_us, read_us, copy_us = 0;
+
+	start = timer_us(0);
+	for (uint64_t i = 0; i < iters; i++)
+		memset(buf, i, size);
+	set_us = timer_us(start);
+
+	start = timer_us(0);
+	for (uint64_t i = 0; i < iters; i++)
+		membench_read(buf, size);
+	read_us = timer_us(start);
+
+	if (copy) {
+		start = timer_us(0);
+		for (uint64_t i = 0; i < iters; i++)
+			memcpy(buf + size, buf, size);
+		copy_us = timer_us(start);
+	}
+
+	printf("%-10s %8lu KiB  memset %6llu  read %6llu", what,
+	       (unsigned long)size / 1024,
+	       (unsigned long long)membench_mib_per_sec(bytes, set_us),
+	       (unsigned long long)membench_mib_per_sec(bytes, read_us));
+	if (copy)
+		printf("  memcpy %6llu",
+		       (unsigned long long)membench_mib_per_sec(bytes,
+								copy_us));
+	printf(" MiB/s\n");
+}
+
+static int membench_heap(void)
+{
+	size_t max = MEMBENCH_MAX_SIZE;
+	uint8_t *buf;
+
+	/* Take the biggest pair of buffers the heap has room for. */
+	while (!(buf = memalign(64, 2 * max)) && max > MEMBENCH_MIN_SIZE)
+		max /= 2;
+	if (!buf) {
+		printf("Failed to allocate a buffer.\n");
+		return 1;
+	}
+
+	for (size_t size = MEMBENCH_MIN_SIZE; size <= max; size *= 4)
+		membench_region("heap", buf, size, 1);
+
+	free(buf);
+	return 0;
+}
+
+static int membench_fb(void)
+{
+	struct cb_framebuffer *fbinfo = lib_sysinfo.framebuffer;
+
+	if (!fbinfo || !fbinfo->physical_address) {
+		printf("No framebuffer.\n");
+		return 1;
+	}
+
+	uint8_t *fb = phys_to_virt(fbinfo->physical_address);
+	size_t size = fbinfo->bytes_per_line * fbinfo->y_resolution;
+	membench_region("fb", fb, size, 0);
+
+	/* Drawing is mostly copying prepared pixels into the framebuffer. */
+	uint8_t *buf = memalign(64, size);
+	if (buf) {
+		memset(buf, 0, size);
+		uint64_t start = timer_us(0);
+		memcpy(fb, buf, size);
+		uint64_t us = timer_us(start);
+		printf("%-10s %8lu KiB  memcpy from heap %6llu MiB/s\n",
+		       "fb", (unsigned long)size / 1024,
+		       (unsigned long long)membench_mib_per_sec(size, us));
+		free(buf);
+	}
+	return 0;
+}
+
+static int membench_phys(uint64_t addr, uint64_t size)
+{
+	uint64_t start = timer_us(0);
+	arch_phys_memset(addr, 0, size);
+	uint64_t us = timer_us(start);
+
+	printf("%#llx %llu KiB  arch_phys_memset %llu MiB/s\n",
+	       (unsigned long long)addr, (unsigned long long)size / 1024,
+	       (unsigned long long)membench_mib_per_sec(size, us));
+	return 0;
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	if (argc == 1)
+		return membench_heap();
+	if (argc == 2 && !strcmp(argv[1], "fb"))
+		return membench_fb();
+	if (argc == 4 && !strcmp(argv[1], "phys"))
+		return membench_phys(strtoull(argv[2], NULL, 16),
+				     strtoull(argv[3], NULL, 16));
+	return CMD_RET_USAGE;
+}
+
 /**************************************************/
 U_BOOT_CMD(
 	md,	3,	1,
@@ -402,3 +545,10 @@ U_BOOT_CMD(
 	"[.b, .w, .l] addr1 addr2 count"
 );
 
+U_BOOT_CMD(
+	membench,	4,	1,
+	"memory bandwidth benchmark",
+	"  - memset/read/memcpy bandwidth for cache to DRAM sized buffers\n"
+	"membench fb  - bandwidth to the framebuffer (overwrites it)\n"
+	"membench phys address length  - arch_phys_memset bandwidth (zeroes it)"
+);
@@ -0,0 +1,29 @@
+/*
+ * Command for dumping or clearing the function call profile.
+ *
+ * Copyright (C) 2016 Chromium OS Authors
+ */
+
+#include "common.h"
+#include "debug/profiler.h"
+
+static int do_profile(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	if (argc == 1 || !strcmp(argv[1], "print")) {
+		profiler_print();
+		return CMD_RET_SUCCESS;
+	}
+	if (!strcmp(argv[1], "reset")) {
+		profiler_reset();
+		return CMD_RET_SUCCESS;
+	}
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	   profile,	2,	1,
+	   "dump or clear the function call profile",
+	   "[print]  - print the profile for util/profiler/dcprof\n"
+	   "profile reset  - discard what's been recorded so far"
+);
@@ -6,6 +6,7 @@
 #include "base/list.h"
 #include "debug/cli/common.h"
 #include "drivers/storage/blockdev.h"
+#include "drivers/storage/stream.h"
 
 typedef struct {
 
@@ -141,6 +142,157 @@ static int storage_init(int argc, char *const argv[])
 	return storage_show(0, NULL);
 }
 
+enum {
+	BenchMaxOps = 100000
+};
+
+static void bench_sort(uint32_t *vals, int count)
+{
+	// Shell sort, since there's no qsort to lean on.
+	for (int gap = count / 2; gap; gap /= 2) {
+		for (int i = gap; i < count; i++) {
+			uint32_t val = vals[i];
+			int j;
+			for (j = i; j >= gap && vals[j - gap] > val; j -= gap)
+				vals[j] = vals[j - gap];
+			vals[j] = val;
+		}
+	}
+}
+
+static void bench_report(const char *what, int count, uint64_t bytes,
+			 uint64_t total_us, uint32_t *latency_us)
+{
+	if (!total_us)
+		total_us = 1;
+
+	uint64_t kib_per_sec = bytes * 1000000 / 1024 / total_us;
+	printf("%s: %d ops, %lld bytes in %lld us\n", what, count,
+	       (long long)bytes, (long long)total_us);
+	printf("  %lld.%02lld MiB/s, %lld IOPS\n",
+	       (long long)(kib_per_sec / 1024),
+	       (long long)(kib_per_sec % 1024 * 100 / 1024),
+	       (long long)(count * 1000000ULL / total_us));
+
+	bench_sort(latency_us, count);
+	printf("  latency us: min %u p50 %u p90 %u p99 %u max %u\n",
+	       latency_us[0], latency_us[count / 2],
+	       latency_us[count * 90 / 100], latency_us[count * 99 / 100],
+	       latency_us[count - 1]);
+}
+
+/*
+ * bench <read|write|stream> <seq|rand> <blks per op> <ops> [start] [span]
+ *
+ * Operations go from start (default 0) through span blocks (default the
+ * rest of the device); random ones are aligned to the op size. Block
+ * devices are synchronous, so there's one operation in flight at a time.
+ */
+static int storage_bench(int argc, char *const argv[])
+{
+	if ((current_devices.curr_device < 0) ||
+	    (current_devices.curr_device >= current_devices.total)) {
+		printf("Is storage subsystem initialized?\n");
+		return -1;
+	}
+	BlockDev *bd = current_devices.known_devices[
+		current_devices.curr_device];
+
+	const char *op = argv[0];
+	int is_read = !strcmp(op, "read");
+	int is_write = !strcmp(op, "write");
+	int is_stream = !strcmp(op, "stream");
+	int random = !strcmp(argv[1], "rand");
+	if ((!is_read && !is_write && !is_stream) ||
+	    (!random && strcmp(argv[1], "seq"))) {
+		printf("Bad bench arguments.\n");
+		return -1;
+	}
+	if (is_stream && random) {
+		printf("Streams can only be read sequentially.\n");
+		return -1;
+	}
+
+	lba_t blocks = strtoul(argv[2], NULL, 0);
+	int count = strtoul(argv[3], NULL, 0);
+	lba_t start = argc > 4 ? strtoull(argv[4], NULL, 0) : 0;
+	lba_t span = argc > 5 ? strtoull(argv[5], NULL, 0) :
+		     bd->block_count - MIN(start, bd->block_count);
+
+	if (!blocks || count <= 0 || count > BenchMaxOps) {
+		printf("Need 1 or more blocks and 1 to %d ops.\n",
+		       BenchMaxOps);
+		return -1;
+	}
+	if (start + span > bd->block_count || span < blocks ||
+	    (!random && blocks * count > span)) {
+		printf("Range doesn't fit on the device.\n");
+		return -1;
+	}
+
+	uint64_t op_bytes = blocks * bd->block_size;
+	uint8_t *buffer = memalign(64, op_bytes);
+	uint32_t *latency_us = malloc(sizeof(*latency_us) * count);
+	if (!buffer || !latency_us) {
+		printf("Failed to allocate bench buffers.\n");
+		free(buffer);
+		free(latency_us);
+		return -1;
+	}
+	memset(buffer, 0xa5, op_bytes);
+
+	StreamOps *stream = NULL;
+	if (is_stream) {
+		stream = bd->ops.new_stream(&bd->ops, start, blocks * count);
+		if (!stream) {
+			printf("Failed to open a stream.\n");
+			free(buffer);
+			free(latency_us);
+			return -1;
+		}
+	}
+
+	int rv = 0;
+	int done;
+	uint64_t bench_start = timer_us(0);
+	for (done = 0; done < count; done++) {
+		lba_t lba = start + done * blocks;
+		if (random)
+			lba = start + (rand() % (span / blocks)) * blocks;
+
+		uint64_t op_start = timer_us(0);
+		int ok;
+		if (is_stream)
+			ok = stream->read(stream, op_bytes, buffer) ==
+			     op_bytes;
+		else if (is_read)
+			ok = bd->ops.read(&bd->ops, lba, blocks, buffer) ==
+			     blocks;
+		else
+			ok = bd->ops.write(&bd->ops, lba, blocks, buffer) ==
+			     blocks;
+		latency_us[done] = timer_us(op_start);
+
+		if (!ok) {
+			printf("Operation %d at block %lld failed.\n", done,
+			       (long long)lba);
+			rv = -1;
+			break;
+		}
+	}
+	uint64_t total_us = timer_us(bench_start);
+
+	if (stream)
+		stream->close(stream);
+
+	if (done)
+		bench_report(op, done, done * op_bytes, total_us, latency_us);
+
+	free(buffer);
+	free(latency_us);
+	return rv;
+}
+
 typedef struct {
 	const char *subcommand_name;
 	int (*subcmd)(int argc, char *const argv[]);
@@ -149,6 +301,7 @@ typedef struct {
 } cmd_map;
 
 static const cmd_map cmdmap[] = {
+	{ "bench", storage_bench, 4, 6 },
 	{ "dev", storage_dev, 0, 1 },
 	{ "init", storage_init, 0, 0 },
 	{ "show", storage_show, 0, 0 },
@@ -183,5 +336,8 @@ U_BOOT_CMD(
 	" show - show currently initialized devices\n"
 	" read <base blk> <num blks> <dest addr> - read from default device\n"
 	" write <base blk> <num blks> <src addr> - write from default device\n"
+	" bench <read|write|stream> <seq|rand> <blks per op> <ops> [start blk]"
+	" [span blks]\n"
+	"   - time I/O on the default device (write destroys data)\n"
 );
 
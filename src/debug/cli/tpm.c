@@ -0,0 +1,21 @@
+/*
+ * Command for showing TPM command statistics.
+ *
+ * Copyright (C) 2016 Chromium OS Authors
+ */
+
+#include "common.h"
+#include "drivers/tpm/tpm.h"
+
+static int do_tpmstats(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	tpm_print_stats();
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	   tpmstats,	1,	1,
+	   "show TPM command statistics",
+	   "  - print count, bytes and latency of TPM commands by ordinal"
+);
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/cleanup_funcs.h"
+#include "base/init_funcs.h"
+#include "debug/profiler.h"
+
+/*
+ * Everything the hooks touch has to be left uninstrumented, or they'd call
+ * themselves. Aggregating into a tree rather than logging every call keeps
+ * the memory use fixed no matter how hot a loop is.
+ */
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+enum {
+	ProfilerMaxNodes = 4096,
+	ProfilerMaxDepth = 64,
+	// Node 0 is the root, which stands for whoever called main().
+	ProfilerRoot = 0
+};
+
+typedef struct {
+	void *func;
+	uint16_t parent;
+	uint16_t first_child;
+	uint16_t next_sibling;
+	uint32_t calls;
+	uint64_t self;
+	uint64_t total;
+} ProfilerNode;
+
+typedef struct {
+	uint16_t node;
+	uint64_t start;
+	// Time spent in callees, to be taken out of this call's self time.
+	uint64_t children;
+} ProfilerFrame;
+
+static ProfilerNode nodes[ProfilerMaxNodes];
+static int num_nodes = 1;
+
+static ProfilerFrame stack[ProfilerMaxDepth];
+static int depth;
+
+// Calls that are too deep or don't fit in the tree are only counted.
+static int skipped_depth;
+static uint32_t dropped;
+
+static int busy;
+
+static NO_INSTRUMENT uint16_t profiler_child(uint16_t parent, void *func)
+{
+	uint16_t prev = 0;
+
+	for (uint16_t child = nodes[parent].first_child; child;
+	     child = nodes[child].next_sibling) {
+		if (nodes[child].func == func) {
+			// Keep the hottest children near the front.
+			if (prev) {
+				nodes[prev].next_sibling =
+					nodes[child].next_sibling;
+				nodes[child].next_sibling =
+					nodes[parent].first_child;
+				nodes[parent].first_child = child;
+			}
+			return child;
+		}
+		prev = child;
+	}
+
+	if (num_nodes == ProfilerMaxNodes)
+		return ProfilerRoot;
+
+	uint16_t child = num_nodes++;
+	nodes[child].func = func;
+	nodes[child].parent = parent;
+	nodes[child].next_sibling = nodes[parent].first_child;
+	nodes[parent].first_child = child;
+	return child;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void *func, void *call_site)
+{
+	if (busy)
+		return;
+	busy = 1;
+
+	if (skipped_depth || depth == ProfilerMaxDepth) {
+		skipped_depth++;
+		dropped++;
+		busy = 0;
+		return;
+	}
+
+	uint16_t parent = depth ? stack[depth - 1].node : ProfilerRoot;
+	uint16_t node = profiler_child(parent, func);
+	if (node == ProfilerRoot) {
+		skipped_depth++;
+		dropped++;
+		busy = 0;
+		return;
+	}
+
+	nodes[node].calls++;
+	ProfilerFrame *frame = &stack[depth++];
+	frame->node = node;
+	frame->children = 0;
+	// Start the clock last so the bookkeeping isn't charged to func.
+	frame->start = timer_raw_value();
+
+	busy = 0;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void *func, void *call_site)
+{
+	uint64_t now = timer_raw_value();
+
+	if (busy)
+		return;
+	busy = 1;
+
+	if (skipped_depth) {
+		skipped_depth--;
+		busy = 0;
+		return;
+	}
+
+	// Frames that never saw their exit (longjmp) are closed here too.
+	while (depth) {
+		ProfilerFrame *frame = &stack[--depth];
+		ProfilerNode *node = &nodes[frame->node];
+		uint64_t elapsed = now - frame->start;
+
+		node->total += elapsed;
+		node->self += elapsed - frame->children;
+		if (depth)
+			stack[depth - 1].children += elapsed;
+		if (node->func == func)
+			break;
+	}
+
+	busy = 0;
+}
+
+NO_INSTRUMENT void profiler_reset(void)
+{
+	busy = 1;
+	memset(nodes, 0, sizeof(nodes));
+	num_nodes = 1;
+	depth = 0;
+	skipped_depth = 0;
+	dropped = 0;
+	busy = 0;
+}
+
+NO_INSTRUMENT void profiler_print(void)
+{
+	busy = 1;
+
+	// Charge the calls still in progress, like main(), up to now.
+	uint64_t now = timer_raw_value();
+	uint64_t open_child = 0;
+	for (int i = depth - 1; i >= 0; i--) {
+		ProfilerFrame *frame = &stack[i];
+		ProfilerNode *node = &nodes[frame->node];
+		uint64_t elapsed = now - frame->start;
+
+		node->total += elapsed;
+		node->self += elapsed - frame->children - open_child;
+		frame->start = now;
+		frame->children = 0;
+		open_child = elapsed;
+	}
+
+	// Times are in timer_raw_value() ticks.
+	printf("profile: hz %llu nodes %d dropped %u\n",
+	       (unsigned long long)timer_hz(), num_nodes - 1, dropped);
+	for (int i = 1; i < num_nodes; i++) {
+		ProfilerNode *node = &nodes[i];
+		printf("profile: %d %d %p %u %llu %llu\n", i, node->parent,
+		       node->func, node->calls,
+		       (unsigned long long)node->self,
+		       (unsigned long long)node->total);
+	}
+	printf("profile: end\n");
+
+	busy = 0;
+}
+
+static NO_INSTRUMENT int profiler_cleanup(CleanupFunc *cleanup,
+					  CleanupType type)
+{
+	profiler_print();
+	return 0;
+}
+
+static CleanupFunc profiler_cleanup_func = {
+	&profiler_cleanup,
+	CleanupOnReboot | CleanupOnPowerOff | CleanupOnHandoff |
+	CleanupOnLegacy,
+	NULL
+};
+
+static NO_INSTRUMENT int profiler_install_cleanup(void)
+{
+	list_insert_after(&profiler_cleanup_func.list_node, &cleanup_funcs);
+	return 0;
+}
+
+INIT_FUNC(profiler_install_cleanup);
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DEBUG_PROFILER_H__
+#define __DEBUG_PROFILER_H__
+
+/*
+ * With CONFIG_PROFILER, every depthcharge function is built with
+ * -finstrument-functions and its calls are accumulated in a calling context
+ * tree: one node per distinct call stack, with a call count and the time
+ * spent in the function itself and in total. The tree is printed to the
+ * console, which also lands in the cbmem console, and util/profiler/dcprof
+ * turns it into a flat profile or folded stacks for flame graphs.
+ */
+
+// Print the tree as "profile:" lines.
+void profiler_print(void);
+// Throw away everything recorded so far.
+void profiler_reset(void);
+
+#endif /* __DEBUG_PROFILER_H__ */
@@ -23,6 +23,13 @@
 typedef struct I2sOps
 {
 	int (*send)(struct I2sOps *me, uint32_t *data, unsigned int length);
+	/*
+	 * Optional. Repeat the buffer from DMA until stop is called, and
+	 * return without waiting for any of it to be played.
+	 */
+	int (*start_loop)(struct I2sOps *me, uint32_t *data,
+			  unsigned int length);
+	int (*stop)(struct I2sOps *me);
 } I2sOps;
 
 #endif /* __DRIVERS_BUS_I2S_I2S_H__ */
@@ -101,6 +101,22 @@ static int mtk_i2s_enable(SoundRouteComponentOps *me)
 	return mtk_i2s_init(bus);
 }
 
+static int mtk_i2s_stop(I2sOps *me)
+{
+	MtkI2s *bus = container_of(me, MtkI2s, ops);
+	Mt8173I2sRegs *regs = bus->regs;
+
+	if (!bus->loop_buffer)
+		return 0;
+
+	/* stop DL1 */
+	clrbits_le32(&regs->dac_con0, 1 << 1);
+
+	free(bus->loop_buffer);
+	bus->loop_buffer = NULL;
+	return 0;
+}
+
 static int mtk_i2s_send(I2sOps *me, uint32_t *data, unsigned int length)
 {
 	MtkI2s *bus = container_of(me, MtkI2s, ops);
@@ -109,6 +125,7 @@ static int mtk_i2s_send(I2sOps *me, uint32_t *data, unsigned int length)
 	uintptr_t buf_size, buf_base, data_end;
 
 	mtk_i2s_init(bus);
+	mtk_i2s_stop(me);
 
 	buf_size = (length + BUFFER_PADDING_LENGTH) * sizeof(uint32_t);
 	buffer = dma_memalign(16, buf_size); /* 16-byte aligned DMA buffer */
@@ -136,12 +153,37 @@ static int mtk_i2s_send(I2sOps *me, uint32_t *data, unsigned int length)
 	return 0;
 }
 
+static int mtk_i2s_start_loop(I2sOps *me, uint32_t *data,
+			      unsigned int length)
+{
+	MtkI2s *bus = container_of(me, MtkI2s, ops);
+	Mt8173I2sRegs *regs = bus->regs;
+	uintptr_t buf_base;
+
+	mtk_i2s_init(bus);
+	mtk_i2s_stop(me);
+
+	/* DL1 wraps from the end back to the base on its own. */
+	bus->loop_buffer = dma_memalign(16, length * sizeof(uint32_t));
+	memcpy(bus->loop_buffer, data, length * sizeof(uint32_t));
+	buf_base = (uintptr_t)bus->loop_buffer;
+	writel(buf_base, &regs->dl1_base);
+	writel(buf_base + length * sizeof(uint32_t) - 1, &regs->dl1_end);
+
+	/* enable DL1 */
+	setbits_le32(&regs->dac_con0, 1 << 1);
+
+	return 0;
+}
+
 MtkI2s *new_mtk_i2s(uintptr_t base, uint32_t channels, uint32_t rate)
 {
 	MtkI2s *bus = xzalloc(sizeof(*bus));
 
 	bus->component.ops.enable = &mtk_i2s_enable;
 	bus->ops.send = &mtk_i2s_send;
+	bus->ops.start_loop = &mtk_i2s_start_loop;
+	bus->ops.stop = &mtk_i2s_stop;
 	bus->regs = (void *)base;
 	bus->channels = channels;
 	bus->rate = rate;
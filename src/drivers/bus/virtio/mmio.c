@@ -0,0 +1,180 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/container_of.h"
+#include "drivers/bus/virtio/mmio.h"
+
+enum {
+	VirtioMmioMagic = 0x74726976	// "virt"
+};
+
+// Both the legacy (version 1) and the version 2 register layouts.
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t device_id;
+	uint32_t vendor_id;
+	uint32_t device_features;
+	uint32_t device_features_sel;
+	uint32_t _rsv0[2];
+	uint32_t driver_features;
+	uint32_t driver_features_sel;
+	uint32_t guest_page_size;	// legacy
+	uint32_t _rsv1;
+	uint32_t queue_sel;
+	uint32_t queue_num_max;
+	uint32_t queue_num;
+	uint32_t queue_align;		// legacy
+	uint32_t queue_pfn;		// legacy
+	uint32_t queue_ready;
+	uint32_t _rsv2[2];
+	uint32_t queue_notify;
+	uint32_t _rsv3[3];
+	uint32_t interrupt_status;
+	uint32_t interrupt_ack;
+	uint32_t _rsv4[2];
+	uint32_t status;
+	uint32_t _rsv5[3];
+	uint32_t queue_desc_low;
+	uint32_t queue_desc_high;
+	uint32_t _rsv6[2];
+	uint32_t queue_driver_low;
+	uint32_t queue_driver_high;
+	uint32_t _rsv7[2];
+	uint32_t queue_device_low;
+	uint32_t queue_device_high;
+	uint32_t _rsv8[21];
+	uint32_t config_generation;
+	uint8_t config[];
+} VirtioMmioRegs;
+
+static VirtioMmioRegs *mmio_regs(VirtioDevOps *me)
+{
+	return container_of(me, VirtioMmio, ops)->regs;
+}
+
+static uint64_t mmio_get_features(VirtioDevOps *me)
+{
+	VirtioMmioRegs *regs = mmio_regs(me);
+
+	writel(1, &regs->device_features_sel);
+	uint64_t features = readl(&regs->device_features);
+	writel(0, &regs->device_features_sel);
+	return (features << 32) | readl(&regs->device_features);
+}
+
+static void mmio_set_features(VirtioDevOps *me, uint64_t features)
+{
+	VirtioMmioRegs *regs = mmio_regs(me);
+
+	writel(1, &regs->driver_features_sel);
+	writel(features >> 32, &regs->driver_features);
+	writel(0, &regs->driver_features_sel);
+	writel(features, &regs->driver_features);
+}
+
+static uint8_t mmio_get_status(VirtioDevOps *me)
+{
+	return readl(&mmio_regs(me)->status);
+}
+
+static void mmio_set_status(VirtioDevOps *me, uint8_t status)
+{
+	writel(status, &mmio_regs(me)->status);
+}
+
+static void mmio_read_config(VirtioDevOps *me, int offset, void *buf,
+			     int size)
+{
+	VirtioMmioRegs *regs = mmio_regs(me);
+	uint8_t *data = buf;
+
+	for (int i = 0; i < size; i++)
+		data[i] = readb(&regs->config[offset + i]);
+}
+
+static int mmio_queue_size(VirtioDevOps *me, int index, int max_size)
+{
+	VirtioMmioRegs *regs = mmio_regs(me);
+
+	writel(index, &regs->queue_sel);
+	int size = readl(&regs->queue_num_max);
+	return MIN(size, max_size);
+}
+
+static int mmio_queue_enable(VirtioDevOps *me, VirtQueue *vq)
+{
+	VirtioMmio *mmio = container_of(me, VirtioMmio, ops);
+	VirtioMmioRegs *regs = mmio->regs;
+
+	writel(vq->index, &regs->queue_sel);
+	writel(vq->size, &regs->queue_num);
+
+	if (mmio->version == 1) {
+		// The used ring starts on the next page after the avail ring.
+		writel(4096, &regs->guest_page_size);
+		writel(4096, &regs->queue_align);
+		writel(virt_to_phys(vq->desc) / 4096, &regs->queue_pfn);
+		return 0;
+	}
+
+	uint64_t desc = virt_to_phys(vq->desc);
+	uint64_t avail = virt_to_phys(vq->avail);
+	uint64_t used = virt_to_phys(vq->used);
+	writel(desc, &regs->queue_desc_low);
+	writel(desc >> 32, &regs->queue_desc_high);
+	writel(avail, &regs->queue_driver_low);
+	writel(avail >> 32, &regs->queue_driver_high);
+	writel(used, &regs->queue_device_low);
+	writel(used >> 32, &regs->queue_device_high);
+	writel(1, &regs->queue_ready);
+	return 0;
+}
+
+static void mmio_notify(VirtioDevOps *me, int index)
+{
+	writel(index, &mmio_regs(me)->queue_notify);
+}
+
+uint32_t virtio_mmio_device_id(uintptr_t base)
+{
+	VirtioMmioRegs *regs = (VirtioMmioRegs *)base;
+
+	if (readl(&regs->magic) != VirtioMmioMagic)
+		return 0;
+	uint32_t version = readl(&regs->version);
+	if (version != 1 && version != 2)
+		return 0;
+	return readl(&regs->device_id);
+}
+
+VirtioMmio *new_virtio_mmio(uintptr_t base)
+{
+	VirtioMmio *mmio = xzalloc(sizeof(*mmio));
+	VirtioMmioRegs *regs = (VirtioMmioRegs *)base;
+
+	mmio->ops.get_features = &mmio_get_features;
+	mmio->ops.set_features = &mmio_set_features;
+	mmio->ops.get_status = &mmio_get_status;
+	mmio->ops.set_status = &mmio_set_status;
+	mmio->ops.read_config = &mmio_read_config;
+	mmio->ops.queue_size = &mmio_queue_size;
+	mmio->ops.queue_enable = &mmio_queue_enable;
+	mmio->ops.notify = &mmio_notify;
+	mmio->regs = regs;
+	mmio->version = readl(&regs->version);
+	mmio->ops.device_id = readl(&regs->device_id);
+	return mmio;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DRIVERS_BUS_VIRTIO_MMIO_H__
+#define __DRIVERS_BUS_VIRTIO_MMIO_H__
+
+#include <stdint.h>
+
+#include "drivers/bus/virtio/virtio.h"
+
+typedef struct {
+	VirtioDevOps ops;
+
+	void *regs;
+	uint32_t version;
+} VirtioMmio;
+
+// Returns the ID of the virtio device at base, or 0 if there isn't one.
+uint32_t virtio_mmio_device_id(uintptr_t base);
+
+VirtioMmio *new_virtio_mmio(uintptr_t base);
+
+#endif /* __DRIVERS_BUS_VIRTIO_MMIO_H__ */
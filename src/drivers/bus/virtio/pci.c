@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/container_of.h"
+#include "drivers/bus/virtio/pci.h"
+
+enum {
+	VirtioPciVendorId = 0x1af4,
+	// Transitional devices are 0x1000 + (virtio device ID - 1).
+	VirtioPciLegacyDeviceFirst = 0x1000,
+	VirtioPciLegacyDeviceLast = 0x103f,
+	// Config space offset of the subsystem ID, which holds the virtio
+	// device ID.
+	VirtioPciSubsystemId = 0x2e
+};
+
+enum {
+	VirtioPciHostFeatures = 0x00,
+	VirtioPciGuestFeatures = 0x04,
+	VirtioPciQueuePfn = 0x08,
+	VirtioPciQueueSize = 0x0c,
+	VirtioPciQueueSelect = 0x0e,
+	VirtioPciQueueNotify = 0x10,
+	VirtioPciStatus = 0x12,
+	VirtioPciIsr = 0x13,
+	// Without MSI-X, which is never enabled here.
+	VirtioPciConfig = 0x14
+};
+
+static uint16_t pci_port(VirtioDevOps *me)
+{
+	return container_of(me, VirtioLegacyPci, ops)->port;
+}
+
+static uint64_t legacy_pci_get_features(VirtioDevOps *me)
+{
+	return inl(pci_port(me) + VirtioPciHostFeatures);
+}
+
+static void legacy_pci_set_features(VirtioDevOps *me, uint64_t features)
+{
+	outl(features, pci_port(me) + VirtioPciGuestFeatures);
+}
+
+static uint8_t legacy_pci_get_status(VirtioDevOps *me)
+{
+	return inb(pci_port(me) + VirtioPciStatus);
+}
+
+static void legacy_pci_set_status(VirtioDevOps *me, uint8_t status)
+{
+	outb(status, pci_port(me) + VirtioPciStatus);
+}
+
+static void legacy_pci_read_config(VirtioDevOps *me, int offset, void *buf,
+				   int size)
+{
+	uint16_t port = pci_port(me) + VirtioPciConfig + offset;
+	uint8_t *data = buf;
+
+	for (int i = 0; i < size; i++)
+		data[i] = inb(port + i);
+}
+
+static int legacy_pci_queue_size(VirtioDevOps *me, int index, int max_size)
+{
+	// The size is fixed by the device. virtio_queue_init() still only uses
+	// max_size entries of it.
+	outw(index, pci_port(me) + VirtioPciQueueSelect);
+	return inw(pci_port(me) + VirtioPciQueueSize);
+}
+
+static int legacy_pci_queue_enable(VirtioDevOps *me, VirtQueue *vq)
+{
+	uint16_t port = pci_port(me);
+
+	outw(vq->index, port + VirtioPciQueueSelect);
+	outl(virt_to_phys(vq->desc) / 4096, port + VirtioPciQueuePfn);
+	return 0;
+}
+
+static void legacy_pci_notify(VirtioDevOps *me, int index)
+{
+	outw(index, pci_port(me) + VirtioPciQueueNotify);
+}
+
+uint32_t virtio_legacy_pci_device_id(pcidev_t dev)
+{
+	uint16_t vendor = pci_read_config16(dev, REG_VENDOR_ID);
+	uint16_t device = pci_read_config16(dev, REG_DEVICE_ID);
+
+	if (vendor != VirtioPciVendorId ||
+	    device < VirtioPciLegacyDeviceFirst ||
+	    device > VirtioPciLegacyDeviceLast)
+		return 0;
+
+	return pci_read_config16(dev, VirtioPciSubsystemId);
+}
+
+VirtioLegacyPci *new_virtio_legacy_pci(pcidev_t dev)
+{
+	VirtioLegacyPci *pci = xzalloc(sizeof(*pci));
+
+	pci->ops.get_features = &legacy_pci_get_features;
+	pci->ops.set_features = &legacy_pci_set_features;
+	pci->ops.get_status = &legacy_pci_get_status;
+	pci->ops.set_status = &legacy_pci_set_status;
+	pci->ops.read_config = &legacy_pci_read_config;
+	pci->ops.queue_size = &legacy_pci_queue_size;
+	pci->ops.queue_enable = &legacy_pci_queue_enable;
+	pci->ops.notify = &legacy_pci_notify;
+	pci->dev = dev;
+	pci->port = pci_read_resource(dev, 0) & ~0x3;
+	pci->ops.device_id = virtio_legacy_pci_device_id(dev);
+
+	pci_set_bus_master(dev);
+	return pci;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DRIVERS_BUS_VIRTIO_PCI_H__
+#define __DRIVERS_BUS_VIRTIO_PCI_H__
+
+#include <pci.h>
+#include <stdint.h>
+
+#include "drivers/bus/virtio/virtio.h"
+
+/*
+ * The legacy I/O port interface. Transitional devices, which is what QEMU
+ * creates on a PCI root bus by default, still provide it.
+ */
+typedef struct {
+	VirtioDevOps ops;
+
+	pcidev_t dev;
+	uint16_t port;
+} VirtioLegacyPci;
+
+/*
+ * Returns the virtio device ID of a transitional device at dev, or 0 if it
+ * isn't one.
+ */
+uint32_t virtio_legacy_pci_device_id(pcidev_t dev);
+
+VirtioLegacyPci *new_virtio_legacy_pci(pcidev_t dev);
+
+#endif /* __DRIVERS_BUS_VIRTIO_PCI_H__ */
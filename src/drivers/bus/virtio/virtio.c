@@ -0,0 +1,181 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "drivers/bus/virtio/virtio.h"
+
+enum {
+	// The legacy transports expect the used ring on its own page.
+	VirtqAlign = 4096
+};
+
+ListNode virtio_devices;
+
+void virtio_reset(VirtioDevOps *dev)
+{
+	dev->set_status(dev, 0);
+}
+
+int virtio_start(VirtioDevOps *dev, uint64_t wanted, uint64_t *features)
+{
+	virtio_reset(dev);
+	dev->set_status(dev, VirtioStatusAcknowledge);
+	dev->set_status(dev, VirtioStatusAcknowledge | VirtioStatusDriver);
+
+	// Devices which offer VERSION_1 won't work without it.
+	uint64_t negotiated = dev->get_features(dev) &
+			      (wanted | VIRTIO_F_VERSION_1);
+	dev->set_features(dev, negotiated);
+
+	if (negotiated & VIRTIO_F_VERSION_1) {
+		uint8_t status = VirtioStatusAcknowledge |
+				 VirtioStatusDriver | VirtioStatusFeaturesOk;
+		dev->set_status(dev, status);
+		if (!(dev->get_status(dev) & VirtioStatusFeaturesOk)) {
+			printf("Virtio device rejected features %#llx.\n",
+			       (unsigned long long)negotiated);
+			dev->set_status(dev, VirtioStatusFailed);
+			return 1;
+		}
+	}
+
+	*features = negotiated;
+	return 0;
+}
+
+void virtio_driver_ok(VirtioDevOps *dev)
+{
+	dev->set_status(dev, dev->get_status(dev) | VirtioStatusDriverOk);
+}
+
+int virtio_queue_init(VirtioDevOps *dev, VirtQueue *vq, int index,
+		      int max_size)
+{
+	int size = dev->queue_size(dev, index, max_size);
+	if (!size || (size & (size - 1))) {
+		printf("Virtio queue %d has unusable size %d.\n", index, size);
+		return 1;
+	}
+
+	size_t avail_offset = sizeof(VirtqDesc) * size;
+	size_t used_offset = ALIGN_UP(avail_offset + sizeof(VirtqAvail) +
+				      sizeof(uint16_t) * (size + 1),
+				      VirtqAlign);
+	size_t total = used_offset + sizeof(VirtqUsed) +
+		       sizeof(VirtqUsedElem) * size + sizeof(uint16_t);
+
+	uint8_t *ring = dma_memalign(VirtqAlign, total);
+	if (!ring) {
+		printf("Failed to allocate virtio queue %d.\n", index);
+		return 1;
+	}
+	memset(ring, 0, total);
+
+	vq->dev = dev;
+	vq->index = index;
+	vq->size = size;
+	vq->desc = (VirtqDesc *)ring;
+	vq->avail = (VirtqAvail *)(ring + avail_offset);
+	vq->used = (VirtqUsed *)(ring + used_offset);
+	vq->tokens = xzalloc(sizeof(*vq->tokens) * size);
+
+	// Legacy devices fix the ring size, so the ring is laid out for all of
+	// it but only max_size descriptors are ever handed out.
+	int usable = MIN(size, max_size);
+	for (int i = 0; i < usable - 1; i++)
+		vq->desc[i].next = i + 1;
+	vq->free_head = 0;
+	vq->num_free = usable;
+	vq->last_used = 0;
+	vq->num_added = 0;
+
+	vq->avail->flags = VirtqAvailFNoInterrupt;
+
+	return dev->queue_enable(dev, vq);
+}
+
+int virtio_queue_add(VirtQueue *vq, const VirtQueueBuf *bufs, int out, int in,
+		     void *token)
+{
+	int count = out + in;
+
+	if (!count || count > vq->num_free)
+		return 1;
+
+	uint16_t head = vq->free_head;
+	uint16_t idx = head;
+	for (int i = 0; i < count; i++) {
+		VirtqDesc *desc = &vq->desc[idx];
+
+		desc->addr = virt_to_phys(bufs[i].addr);
+		desc->len = bufs[i].len;
+		desc->flags = 0;
+		if (i >= out)
+			desc->flags |= VirtqDescFWrite;
+		if (i < count - 1)
+			desc->flags |= VirtqDescFNext;
+		idx = desc->next;
+	}
+	vq->free_head = idx;
+	vq->num_free -= count;
+	vq->tokens[head] = token;
+
+	uint16_t avail_idx = vq->avail->idx;
+	vq->avail->ring[avail_idx & (vq->size - 1)] = head;
+	// The descriptors have to be visible before the index moves.
+	__sync_synchronize();
+	*(volatile uint16_t *)&vq->avail->idx = avail_idx + 1;
+	vq->num_added++;
+
+	return 0;
+}
+
+void virtio_queue_kick(VirtQueue *vq)
+{
+	if (!vq->num_added)
+		return;
+	vq->num_added = 0;
+
+	__sync_synchronize();
+	if (*(volatile uint16_t *)&vq->used->flags & VirtqUsedFNoNotify)
+		return;
+	vq->dev->notify(vq->dev, vq->index);
+}
+
+void *virtio_queue_get_used(VirtQueue *vq, uint32_t *len)
+{
+	if (*(volatile uint16_t *)&vq->used->idx == vq->last_used)
+		return NULL;
+	// Don't read the element before seeing the index that covers it.
+	__sync_synchronize();
+
+	VirtqUsedElem *elem = &vq->used->ring[vq->last_used & (vq->size - 1)];
+	uint16_t head = elem->id;
+	if (len)
+		*len = elem->len;
+	vq->last_used++;
+
+	uint16_t idx = head;
+	vq->num_free++;
+	while (vq->desc[idx].flags & VirtqDescFNext) {
+		idx = vq->desc[idx].next;
+		vq->num_free++;
+	}
+	vq->desc[idx].next = vq->free_head;
+	vq->free_head = head;
+
+	void *token = vq->tokens[head];
+	vq->tokens[head] = NULL;
+	return token;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DRIVERS_BUS_VIRTIO_VIRTIO_H__
+#define __DRIVERS_BUS_VIRTIO_VIRTIO_H__
+
+#include <stdint.h>
+
+#include "base/list.h"
+
+/*
+ * Split virtqueues and feature negotiation shared by the virtio device
+ * drivers. Everything is polled; the device is never asked for interrupts.
+ */
+
+enum {
+	VirtioIdNet = 1,
+	VirtioIdBlock = 2
+};
+
+enum {
+	VirtioStatusAcknowledge = 1 << 0,
+	VirtioStatusDriver = 1 << 1,
+	VirtioStatusDriverOk = 1 << 2,
+	VirtioStatusFeaturesOk = 1 << 3,
+	VirtioStatusFailed = 1 << 7
+};
+
+#define VIRTIO_F_VERSION_1 (1ULL << 32)
+
+typedef struct {
+	uint64_t addr;
+	uint32_t len;
+	uint16_t flags;
+	uint16_t next;
+} __attribute__((packed)) VirtqDesc;
+
+enum {
+	VirtqDescFNext = 1 << 0,
+	VirtqDescFWrite = 1 << 1
+};
+
+typedef struct {
+	uint16_t flags;
+	uint16_t idx;
+	uint16_t ring[];
+} __attribute__((packed)) VirtqAvail;
+
+enum {
+	VirtqAvailFNoInterrupt = 1 << 0
+};
+
+typedef struct {
+	uint32_t id;
+	uint32_t len;
+} __attribute__((packed)) VirtqUsedElem;
+
+typedef struct {
+	uint16_t flags;
+	uint16_t idx;
+	VirtqUsedElem ring[];
+} __attribute__((packed)) VirtqUsed;
+
+enum {
+	VirtqUsedFNoNotify = 1 << 0
+};
+
+struct VirtQueue;
+
+// Implemented by each transport.
+typedef struct VirtioDevOps {
+	uint64_t (*get_features)(struct VirtioDevOps *me);
+	void (*set_features)(struct VirtioDevOps *me, uint64_t features);
+	uint8_t (*get_status)(struct VirtioDevOps *me);
+	void (*set_status)(struct VirtioDevOps *me, uint8_t status);
+	void (*read_config)(struct VirtioDevOps *me, int offset, void *buf,
+			    int size);
+	// Number of entries queue index will have, 0 if it doesn't exist.
+	int (*queue_size)(struct VirtioDevOps *me, int index, int max_size);
+	int (*queue_enable)(struct VirtioDevOps *me, struct VirtQueue *vq);
+	void (*notify)(struct VirtioDevOps *me, int index);
+
+	uint32_t device_id;
+	ListNode list_node;
+} VirtioDevOps;
+
+/*
+ * Devices the board found but didn't hand to a driver itself, like network
+ * devices which only the netboot image has a driver for.
+ */
+extern ListNode virtio_devices;
+
+typedef struct VirtQueue {
+	VirtioDevOps *dev;
+	uint16_t index;
+	uint16_t size;
+
+	VirtqDesc *desc;
+	VirtqAvail *avail;
+	VirtqUsed *used;
+
+	uint16_t free_head;
+	uint16_t num_free;
+	uint16_t last_used;
+	// Descriptors made available since the device was last notified.
+	uint16_t num_added;
+	void **tokens;
+} VirtQueue;
+
+// One element of a descriptor chain.
+typedef struct {
+	void *addr;
+	uint32_t len;
+} VirtQueueBuf;
+
+/*
+ * Reset the device, negotiate features and acknowledge it. wanted is masked
+ * by what the device offers and the result is returned in *features. Returns
+ * non-zero on failure.
+ */
+int virtio_start(VirtioDevOps *dev, uint64_t wanted, uint64_t *features);
+void virtio_driver_ok(VirtioDevOps *dev);
+void virtio_reset(VirtioDevOps *dev);
+
+/*
+ * Set up queue index with at most max_size entries in use. Completions are
+ * polled, so the device is asked not to raise interrupts. Returns non-zero
+ * on failure.
+ */
+int virtio_queue_init(VirtioDevOps *dev, VirtQueue *vq, int index,
+		      int max_size);
+
+/*
+ * Add a chain of out device readable buffers followed by in device writable
+ * buffers. token is handed back by virtio_queue_get_used() when the device
+ * is done with it. The device isn't told until virtio_queue_kick(). Returns
+ * non-zero if there aren't enough free descriptors.
+ */
+int virtio_queue_add(VirtQueue *vq, const VirtQueueBuf *bufs, int out, int in,
+		     void *token);
+
+// Notify the device of new buffers, unless it asked not to be.
+void virtio_queue_kick(VirtQueue *vq);
+
+/*
+ * Reclaim the next buffer chain the device has finished with. Returns its
+ * token, or NULL if there aren't any. *len is set to the number of bytes
+ * the device wrote.
+ */
+void *virtio_queue_get_used(VirtQueue *vq, uint32_t *len);
+
+#endif /* __DRIVERS_BUS_VIRTIO_VIRTIO_H__ */
@@ -53,6 +53,24 @@ static int max_param_size;
 static int passthru_param_size;
 static int initialized;
 
+/*
+ * Properties of the EC (devidx 0) and the PD chip behind it (devidx 1)
+ * which don't change while the same image is running. They're looked up on
+ * first use and cached so that flash accesses don't repeat the queries every
+ * time, and forgotten when the chip reboots, since RO and RW can differ.
+ */
+typedef struct CrosEcCaps {
+	int flash_info_valid;
+	struct ec_response_flash_info flash_info;
+	uint32_t flash_write_burst;
+} CrosEcCaps;
+
+static CrosEcCaps cros_ec_caps[2];
+
+/* Scratch buffer for building flash write requests. */
+static uint8_t *flash_write_buf;
+static uint32_t flash_write_buf_size;
+
 #define DEFAULT_BUF_SIZE 0x100
 
 int cros_ec_set_bus(CrosEcBusOps *bus)
@@ -71,8 +89,21 @@ static const int CROS_EC_CMD_TIMEOUT_MS = 5000;
 /* Timeout waiting for EC hash calculation completion */
 static const int CROS_EC_HASH_TIMEOUT_MS = 2000;
 
-/* Time to delay between polling status of EC hash calculation */
-static const int CROS_EC_HASH_CHECK_DELAY_MS = 10;
+/*
+ * Time to delay between polling status of EC hash calculation. The delay
+ * starts short, since the hash was usually started early and is nearly done,
+ * and doubles on each poll up to the maximum.
+ */
+static const int CROS_EC_HASH_CHECK_DELAY_MIN_MS = 1;
+static const int CROS_EC_HASH_CHECK_DELAY_MAX_MS = 16;
+
+/*
+ * Time to delay between polling the status of a command which is still in
+ * progress. Most commands finish quickly, so start with a short delay and
+ * double it on every poll up to the maximum.
+ */
+static const int CROS_EC_BUSY_DELAY_MIN_US = 500;
+static const int CROS_EC_BUSY_DELAY_MAX_US = 50 * 1000;
 
 /* Note: depends on enum ec_current_image */
 static const char * const ec_current_image_name[] = {"unknown", "RO", "RW"};
@@ -274,12 +305,15 @@ static int send_command_proto3(int cmd, int cmd_version,
 		struct ec_response_get_comms_status resp;
 		uint64_t start;
 
+		int delay = CROS_EC_BUSY_DELAY_MIN_US;
+
 		/* Wait for command to complete */
 		start = timer_us(0);
 		do {
 			int ret;
 
-			mdelay(50);	/* Insert some reasonable delay */
+			udelay(delay);
+			delay = MIN(delay * 2, CROS_EC_BUSY_DELAY_MAX_US);
 			ret = send_command_proto3_work(EC_CMD_GET_COMMS_STATUS,
 				0, NULL, 0, &resp, sizeof(resp));
 			if (ret < 0)
@@ -336,12 +370,15 @@ static int send_command_proto2(int cmd, int cmd_version,
 		struct ec_response_get_comms_status resp;
 		uint64_t start;
 
+		int delay = CROS_EC_BUSY_DELAY_MIN_US;
+
 		/* Wait for command to complete */
 		start = timer_us(0);
 		do {
 			int ret;
 
-			mdelay(50);	/* Insert some reasonable delay */
+			udelay(delay);
+			delay = MIN(delay * 2, CROS_EC_BUSY_DELAY_MAX_US);
 			ret = cros_ec_bus->send_command(
 				cros_ec_bus, EC_CMD_GET_COMMS_STATUS,
 				0, NULL, 0, &resp, sizeof(resp));
@@ -442,6 +479,18 @@ int cros_ec_scan_keyboard(struct cros_ec_keyscan *scan)
 	return 0;
 }
 
+int cros_ec_get_next_event(struct ec_response_get_next_event *event)
+{
+	int ret = ec_command(EC_CMD_GET_NEXT_EVENT, 0, NULL, 0,
+			     event, sizeof(*event));
+	if (ret < 0)
+		return ret;
+	if (ret < sizeof(event->event_type))
+		return -1;
+
+	return 0;
+}
+
 int cros_ec_read_id(char *id, int maxlen)
 {
 	struct ec_response_get_version r;
@@ -498,11 +547,49 @@ int cros_ec_read_current_image(int devidx, enum ec_current_image *image)
 	return 0;
 }
 
+static int cros_ec_request_hash(int devidx,
+				struct ec_response_vboot_hash *hash)
+{
+	struct ec_params_vboot_hash p;
+
+	p.cmd = EC_VBOOT_HASH_START;
+	p.hash_type = EC_VBOOT_HASH_TYPE_SHA256;
+	p.nonce_size = 0;
+	p.offset = EC_VBOOT_HASH_OFFSET_RW;
+
+	if (ec_command(EC_CMD_PASSTHRU_OFFSET(devidx) + EC_CMD_VBOOT_HASH, 0,
+		       &p, sizeof(p), hash, sizeof(*hash)) < 0)
+		return -1;
+
+	return 0;
+}
+
+int cros_ec_start_hash(int devidx)
+{
+	struct ec_params_vboot_hash p;
+	struct ec_response_vboot_hash hash;
+
+	p.cmd = EC_VBOOT_HASH_GET;
+	if (ec_command(EC_CMD_PASSTHRU_OFFSET(devidx) + EC_CMD_VBOOT_HASH, 0,
+		       &p, sizeof(p), &hash, sizeof(hash)) < 0)
+		return -1;
+
+	/* Leave a finished or in progress hash alone. */
+	if (hash.status != EC_VBOOT_HASH_STATUS_NONE)
+		return 0;
+
+	printf("%s: Starting EC hash computation for devidx=%d\n",
+	       __func__, devidx);
+	return cros_ec_request_hash(devidx, &hash);
+}
+
 int cros_ec_read_hash(int devidx, struct ec_response_vboot_hash *hash)
 {
 	struct ec_params_vboot_hash p;
 	uint64_t start;
 	int recalc_requested = 0;
+	int waited = 0;
+	int delay = CROS_EC_HASH_CHECK_DELAY_MIN_MS;
 
 	start = timer_us(0);
 	do {
@@ -523,14 +610,7 @@ int cros_ec_read_hash(int devidx, struct ec_response_vboot_hash *hash)
 			      "Compute one...\n", __func__, hash->status,
 			      hash->size);
 
-			p.cmd = EC_VBOOT_HASH_START;
-			p.hash_type = EC_VBOOT_HASH_TYPE_SHA256;
-			p.nonce_size = 0;
-			p.offset = EC_VBOOT_HASH_OFFSET_RW;
-
-			if (ec_command(EC_CMD_PASSTHRU_OFFSET(devidx) +
-				       EC_CMD_VBOOT_HASH, 0, &p,
-				       sizeof(p), hash, sizeof(*hash)) < 0)
+			if (cros_ec_request_hash(devidx, hash))
 				return -1;
 
 			recalc_requested = 1;
@@ -540,7 +620,9 @@ int cros_ec_read_hash(int devidx, struct ec_response_vboot_hash *hash)
 			break;
 		case EC_VBOOT_HASH_STATUS_BUSY:
 			/* Hash is still calculating. */
-			mdelay(CROS_EC_HASH_CHECK_DELAY_MS);
+			mdelay(delay);
+			waited = 1;
+			delay = MIN(delay * 2, CROS_EC_HASH_CHECK_DELAY_MAX_MS);
 			break;
 		case EC_VBOOT_HASH_STATUS_DONE:
 		default:
@@ -556,6 +638,10 @@ int cros_ec_read_hash(int devidx, struct ec_response_vboot_hash *hash)
 		return -1;
 	}
 
+	if (waited)
+		printf("%s: Hash for devidx=%d ready after %llu us\n",
+		       __func__, devidx, timer_us(start));
+
 	return 0;
 }
 
@@ -584,6 +670,10 @@ int cros_ec_reboot(int devidx, enum ec_reboot_cmd cmd, uint8_t flags)
 
 		if (!timeout)
 			return -1;
+
+		if (devidx >= 0 && devidx < ARRAY_SIZE(cros_ec_caps))
+			memset(&cros_ec_caps[devidx], 0,
+			       sizeof(cros_ec_caps[devidx]));
 	}
 
 	return 0;
@@ -754,7 +844,13 @@ static int cros_ec_flash_write_block(int devidx, const uint8_t *data,
 	if (bufsize > (devidx == 0 ? max_param_size : passthru_param_size))
 		return -1;
 
-	buf = xmalloc(bufsize);
+	/* Keep the request buffer around, it's reused for every block. */
+	if (bufsize > flash_write_buf_size) {
+		free(flash_write_buf);
+		flash_write_buf = xmalloc(bufsize);
+		flash_write_buf_size = bufsize;
+	}
+	buf = flash_write_buf;
 
 	p = (struct ec_params_flash_write *)buf;
 	p->offset = offset;
@@ -764,15 +860,38 @@ static int cros_ec_flash_write_block(int devidx, const uint8_t *data,
 	rv = ec_command(EC_CMD_PASSTHRU_OFFSET(devidx) + EC_CMD_FLASH_WRITE,
 			0, buf, bufsize, NULL, 0) >= 0 ? 0 : -1;
 
-	free(buf);
-
 	return rv;
 }
 
-/**
- * Return optimal flash write burst size
- */
-static int cros_ec_flash_write_burst_size(int devidx)
+static CrosEcCaps *cros_ec_get_caps(int devidx)
+{
+	if (devidx < 0 || devidx >= ARRAY_SIZE(cros_ec_caps))
+		return NULL;
+	return &cros_ec_caps[devidx];
+}
+
+static int cros_ec_flash_info(int devidx, struct ec_response_flash_info *info)
+{
+	CrosEcCaps *caps = cros_ec_get_caps(devidx);
+
+	if (caps && caps->flash_info_valid) {
+		*info = caps->flash_info;
+		return 0;
+	}
+
+	if (ec_command(EC_CMD_PASSTHRU_OFFSET(devidx) + EC_CMD_FLASH_INFO, 0,
+		       NULL, 0, info, sizeof(*info)) < sizeof(*info))
+		return -1;
+
+	if (caps) {
+		caps->flash_info = *info;
+		caps->flash_info_valid = 1;
+	}
+
+	return 0;
+}
+
+static int cros_ec_calc_flash_write_burst_size(int devidx)
 {
 	struct ec_response_flash_info info;
 	uint32_t pdata_max_size =
@@ -791,14 +910,30 @@ static int cros_ec_flash_write_burst_size(int devidx)
 	 * Determine step size.  This must be a multiple of the write block
 	 * size, and must also fit into the host parameter buffer.
 	 */
-	if (ec_command(EC_CMD_PASSTHRU_OFFSET(devidx) + EC_CMD_FLASH_INFO, 0,
-		       NULL, 0, &info, sizeof(info)) < sizeof(info))
+	if (cros_ec_flash_info(devidx, &info))
 		return 0;
 
 	return (pdata_max_size / info.write_block_size) *
 		info.write_block_size;
 }
 
+/**
+ * Return optimal flash write burst size
+ */
+static int cros_ec_flash_write_burst_size(int devidx)
+{
+	CrosEcCaps *caps = cros_ec_get_caps(devidx);
+
+	if (!caps)
+		return cros_ec_calc_flash_write_burst_size(devidx);
+
+	if (!caps->flash_write_burst)
+		caps->flash_write_burst =
+			cros_ec_calc_flash_write_burst_size(devidx);
+
+	return caps->flash_write_burst;
+}
+
 int cros_ec_flash_write(int devidx, const uint8_t *data, uint32_t offset,
 			uint32_t size)
 {
@@ -877,9 +1012,67 @@ int cros_ec_flash_read(int devidx, uint8_t *data, uint32_t offset,
 	return 0;
 }
 
+static int cros_ec_flash_is_erased(const uint8_t *data, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i++)
+		if (data[i] != 0xff)
+			return 0;
+	return 1;
+}
+
+/**
+ * Bring one erase block of the EC flash up to date.
+ *
+ * The block is read back first and only erased and programmed if it doesn't
+ * already hold the expected contents.
+ *
+ * @param expected	Expected contents of the whole block
+ * @param data_size	Number of leading bytes in expected which aren't
+ *			known to be 0xff and need to be programmed
+ * @param current	Scratch buffer the size of the block
+ * @return 1 if the block was updated, 0 if it was already up to date,
+ *	   or -1 on error
+ */
+static int cros_ec_flash_update_block(int devidx, uint32_t offset,
+				      const uint8_t *expected,
+				      uint32_t data_size, uint8_t *current,
+				      const struct ec_response_flash_info *info,
+				      uint32_t burst)
+{
+	uint32_t size = info->erase_block_size;
+	uint32_t off;
+
+	if (cros_ec_flash_read(devidx, current, offset, size))
+		return -1;
+
+	if (!memcmp(current, expected, size))
+		return 0;
+
+	if (!cros_ec_flash_is_erased(current, size) &&
+	    cros_ec_flash_erase(devidx, offset, size))
+		return -1;
+
+	/*
+	 * Write in whole write blocks without spilling into the next erase
+	 * block, which may still hold data and can't be written over.
+	 */
+	data_size = ALIGN_UP(data_size, info->write_block_size);
+	for (off = 0; off < data_size; off += burst) {
+		if (cros_ec_flash_write_block(devidx, expected + off,
+					      offset + off,
+					      MIN(data_size - off, burst)))
+			return -1;
+	}
+
+	return 1;
+}
+
 int cros_ec_flash_update_rw(int devidx, const uint8_t *image, int image_size)
 {
-	uint32_t rw_offset, rw_size;
+	struct ec_response_flash_info info;
+	uint32_t rw_offset, rw_size, burst, block_size, offset;
+	uint8_t *expected, *current;
+	int updated = 0;
 	int ret;
 
 	if (cros_ec_flash_offset(devidx, EC_FLASH_REGION_RW,
@@ -888,24 +1081,62 @@ int cros_ec_flash_update_rw(int devidx, const uint8_t *image, int image_size)
 	if (image_size > rw_size)
 		return -1;
 
+	burst = cros_ec_flash_write_burst_size(devidx);
+	if (!burst || cros_ec_flash_info(devidx, &info))
+		return -1;
+	block_size = info.erase_block_size;
+
+	if (!block_size || !info.write_block_size ||
+	    block_size % info.write_block_size ||
+	    rw_offset % block_size || rw_size % block_size) {
+		/*
+		 * Erase the entire RW section, so that the EC doesn't see any
+		 * garbage past the new image if it's smaller than the current
+		 * image.
+		 */
+		ret = cros_ec_flash_erase(devidx, rw_offset, rw_size);
+		if (ret)
+			return ret;
+
+		return cros_ec_flash_write(devidx, image, rw_offset,
+					   image_size);
+	}
+
+	/* Trailing padding doesn't need to be written to erased flash. */
+	while (image_size > 0 && image[image_size - 1] == 0xff)
+		image_size--;
+
 	/*
-	 * Erase the entire RW section, so that the EC doesn't see any garbage
-	 * past the new image if it's smaller than the current image.
-	 *
-	 * TODO: could optimize this to erase just the current image, since
-	 * presumably everything past that is 0xff's.  But would still need to
-	 * round up to the nearest multiple of erase size.
+	 * Only touch erase blocks whose contents differ from the new image,
+	 * which should be 0xff past its end so the EC doesn't see any
+	 * garbage if it's smaller than the current image.
 	 */
-	ret = cros_ec_flash_erase(devidx, rw_offset, rw_size);
-	if (ret)
-		return ret;
+	expected = xmalloc(block_size);
+	current = xmalloc(block_size);
+	ret = 0;
+	for (offset = 0; offset < rw_size; offset += block_size) {
+		uint32_t data_size = 0;
+
+		if (offset < image_size)
+			data_size = MIN(image_size - offset, block_size);
+		memset(expected, 0xff, block_size);
+		memcpy(expected, image + offset, data_size);
+
+		ret = cros_ec_flash_update_block(devidx, rw_offset + offset,
+						 expected, data_size, current,
+						 &info, burst);
+		if (ret < 0)
+			break;
+		updated += ret;
+		ret = 0;
+	}
+	free(current);
+	free(expected);
 
-	/* Write the image */
-	ret = cros_ec_flash_write(devidx, image, rw_offset, image_size);
-	if (ret)
-		return ret;
+	printf("%s: Updated %d of %d EC flash blocks.\n", __func__, updated,
+	       rw_size / block_size);
 
-	return 0;
+	return ret;
 }
 
 int cros_ec_read_vbnvcontext(uint8_t *block)
@@ -1033,21 +1264,28 @@ int cros_ec_read_batt_state_of_charge(uint32_t *state)
 static int set_max_proto3_sizes(int request_size, int response_size,
 				int passthru_size)
 {
-	free(proto3_request);
-	free(proto3_response);
-
-	if (request_size)
-		proto3_request = xmalloc(request_size);
-	else
-		proto3_request = NULL;
-	if (response_size)
-		proto3_response = xmalloc(response_size);
-	else
-		proto3_response = NULL;
+	/* Only reallocate the packet buffers if their size changes. */
+	if (request_size != proto3_request_size) {
+		free(proto3_request);
+		if (request_size)
+			proto3_request = xmalloc(request_size);
+		else
+			proto3_request = NULL;
+	}
+	if (response_size != proto3_response_size) {
+		free(proto3_response);
+		if (response_size)
+			proto3_response = xmalloc(response_size);
+		else
+			proto3_response = NULL;
+	}
 
 	proto3_request_size = request_size;
 	proto3_response_size = response_size;
 
+	/* Burst sizes depend on the packet sizes. */
+	memset(cros_ec_caps, 0, sizeof(cros_ec_caps));
+
 	max_param_size = proto3_request_size - sizeof(struct ec_host_request);
 
 	passthru_param_size = passthru_size - sizeof(struct ec_host_request);
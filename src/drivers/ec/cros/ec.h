@@ -118,6 +118,16 @@ int cros_ec_get_protocol_info(int devidx,
  */
 int cros_ec_scan_keyboard(struct cros_ec_keyscan *scan);
 
+/**
+ * Read the next pending MKBP event from the ChromeOS EC device
+ *
+ * @param event		Place to put the event
+ * @return 0 if ok, -EC_RES_UNAVAILABLE if no event is pending,
+ *	   -EC_RES_INVALID_COMMAND if the EC doesn't support event
+ *	   reporting, or another value <0 on error
+ */
+int cros_ec_get_next_event(struct ec_response_get_next_event *event);
+
 /**
  * Read which image is currently running on the ChromeOS EC device.
  *
@@ -136,6 +146,18 @@ int cros_ec_read_current_image(int devidx, enum ec_current_image *image);
  */
 int cros_ec_read_hash(int devidx, struct ec_response_vboot_hash *hash);
 
+/**
+ * Ask the ChromeOS EC device to start hashing its RW firmware.
+ *
+ * The hash is computed in the background by the EC, and can be picked up
+ * later with cros_ec_read_hash(). Nothing is done if a hash is already
+ * available or being computed.
+ *
+ * @param devidx	Index of target device
+ * @return 0 if ok, <0 on error
+ */
+int cros_ec_start_hash(int devidx);
+
 /**
  * Send a reboot command to the ChromeOS EC device.
  *
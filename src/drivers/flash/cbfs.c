@@ -21,7 +21,9 @@
 
 #include <libpayload.h>
 #include <cbfs.h>
+#include "base/list.h"
 #include "image/fmap.h"
+#include "drivers/flash/cbfs.h"
 #include "drivers/flash/flash.h"
 
 /* flash as CBFS media. */
@@ -114,3 +116,266 @@ int cbfs_media_from_fmap(struct cbfs_media *media, const char *name)
 
 	return 0;
 }
+
+/*
+ * libpayload walks the CBFS header chain from the start on every lookup,
+ * which on SPI flash is a transaction or two per file. Instead, each CBFS is
+ * walked once the first time it's searched, and its files are remembered in
+ * a hash table keyed by name. Anything the index can't serve, like a file it
+ * didn't find or a compressed one, is still handed to libpayload.
+ */
+
+typedef struct {
+	char *name;
+	uint32_t hash;
+	// Where the file's header starts within the media.
+	uint32_t offset;
+	// The size of the header, name and attributes, and of the data.
+	uint32_t header_len;
+	uint32_t len;
+	uint32_t type;
+} CbfsIndexEntry;
+
+typedef struct {
+	// The FMAP area the CBFS is in, or NULL for the default CBFS.
+	char *region;
+
+	CbfsIndexEntry *entries;
+	int count;
+
+	// Open addressed, holding entry index + 1, or 0 if empty.
+	uint16_t *buckets;
+	uint32_t mask;
+
+	ListNode list_node;
+} CbfsIndex;
+
+static ListNode cbfs_indexes;
+
+static uint32_t cbfs_index_hash(const char *name)
+{
+	// FNV-1a.
+	uint32_t hash = 2166136261U;
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static int cbfs_index_media(struct cbfs_media *media, const char *region)
+{
+	if (region)
+		return cbfs_media_from_fmap(media, region);
+	return libpayload_init_default_cbfs_media(media);
+}
+
+static const CbfsIndexEntry *cbfs_index_find(CbfsIndex *index,
+					     const char *name)
+{
+	if (!index->count)
+		return NULL;
+
+	uint32_t hash = cbfs_index_hash(name);
+	for (uint32_t i = hash & index->mask; index->buckets[i];
+	     i = (i + 1) & index->mask) {
+		CbfsIndexEntry *entry = &index->entries[index->buckets[i] - 1];
+		if (entry->hash == hash && !strcmp(entry->name, name))
+			return entry;
+	}
+	return NULL;
+}
+
+static void cbfs_index_hash_entries(CbfsIndex *index)
+{
+	uint32_t size = 1;
+	while (size < 2 * (uint32_t)index->count)
+		size <<= 1;
+
+	index->buckets = xzalloc(size * sizeof(*index->buckets));
+	index->mask = size - 1;
+
+	for (int i = 0; i < index->count; i++) {
+		CbfsIndexEntry *entry = &index->entries[i];
+
+		// Like libpayload, the first file with a name wins.
+		if (cbfs_index_find(index, entry->name))
+			continue;
+
+		uint32_t slot = entry->hash & index->mask;
+		while (index->buckets[slot])
+			slot = (slot + 1) & index->mask;
+		index->buckets[slot] = i + 1;
+	}
+}
+
+static void cbfs_index_walk(CbfsIndex *index, struct cbfs_media *media,
+			    size_t offset, size_t end)
+{
+	int capacity = 0;
+
+	while (offset + sizeof(struct cbfs_file) <= end &&
+	       index->count < UINT16_MAX) {
+		struct cbfs_file file;
+
+		if (media->read(media, &file, offset, sizeof(file)) !=
+		    sizeof(file))
+			break;
+		// The rest of the CBFS is either free space or not CBFS at all.
+		if (memcmp(file.magic, CBFS_FILE_MAGIC, sizeof(file.magic)))
+			break;
+
+		uint32_t header_len = ntohl(file.offset);
+		uint32_t len = ntohl(file.len);
+		if (header_len <= sizeof(file) || header_len > end - offset ||
+		    len > end - offset - header_len)
+			break;
+
+		size_t name_max = header_len - sizeof(file);
+		const char *name = media->map(media, offset + sizeof(file),
+					      name_max);
+		if (name == CBFS_MEDIA_INVALID_MAP_ADDRESS)
+			break;
+
+		if (index->count == capacity) {
+			int new_capacity = capacity ? capacity * 2 : 32;
+			CbfsIndexEntry *entries = realloc(index->entries,
+				new_capacity * sizeof(*entries));
+			if (!entries) {
+				media->unmap(media, name);
+				break;
+			}
+			index->entries = entries;
+			capacity = new_capacity;
+		}
+
+		CbfsIndexEntry *entry = &index->entries[index->count++];
+		size_t name_len = strnlen(name, name_max);
+		entry->name = xmalloc(name_len + 1);
+		memcpy(entry->name, name, name_len);
+		entry->name[name_len] = '\0';
+		media->unmap(media, name);
+
+		entry->hash = cbfs_index_hash(entry->name);
+		entry->offset = offset;
+		entry->header_len = header_len;
+		entry->len = len;
+		entry->type = ntohl(file.type);
+
+		offset = ALIGN_UP(offset + header_len + len, CBFS_ALIGNMENT);
+	}
+}
+
+static CbfsIndex *cbfs_index_get(const char *region)
+{
+	CbfsIndex *index;
+
+	list_for_each(index, cbfs_indexes, list_node) {
+		if (region ? index->region && !strcmp(index->region, region) :
+			     !index->region)
+			return index;
+	}
+
+	struct cbfs_media media;
+	if (cbfs_index_media(&media, region))
+		return NULL;
+
+	// An index that couldn't be built is kept too, so it isn't retried.
+	index = xzalloc(sizeof(*index));
+	if (region)
+		index->region = strdup(region);
+	list_insert_after(&index->list_node, &cbfs_indexes);
+
+	if (region) {
+		FmapArea *area = media.context;
+		cbfs_index_walk(index, &media, 0, area->size);
+	} else {
+		const struct cbfs_header *header = cbfs_get_header(&media);
+		if (header != CBFS_HEADER_INVALID_POINTER)
+			cbfs_index_walk(index, &media, ntohl(header->offset),
+					ntohl(header->romsize));
+	}
+	media.close(&media);
+
+	if (index->count)
+		cbfs_index_hash_entries(index);
+	return index;
+}
+
+struct cbfs_file *cbfs_index_get_file(const char *region, const char *name)
+{
+	CbfsIndex *index = cbfs_index_get(region);
+	const CbfsIndexEntry *entry = index ? cbfs_index_find(index, name) :
+					      NULL;
+	struct cbfs_media media;
+	struct cbfs_file *file;
+
+	if (cbfs_index_media(&media, region))
+		return NULL;
+
+	if (entry) {
+		file = media.map(&media, entry->offset,
+				 entry->header_len + entry->len);
+		if (file == CBFS_MEDIA_INVALID_MAP_ADDRESS)
+			file = NULL;
+	} else {
+		file = cbfs_get_file(&media, name);
+	}
+	media.close(&media);
+
+	return file;
+}
+
+void *cbfs_index_get_file_content(const char *region, const char *name,
+				  int type, size_t *sz)
+{
+	if (sz)
+		*sz = 0;
+
+	struct cbfs_file *file = cbfs_index_get_file(region, name);
+	if (!file)
+		return NULL;
+	if (ntohl(file->type) != (uint32_t)type) {
+		printf("File '%s' is of type %x, but %x was requested.\n",
+		       name, ntohl(file->type), type);
+		return NULL;
+	}
+
+	// Leave decompressing to libpayload.
+	if (cbfs_file_find_attr(file, CBFS_FILE_ATTR_TAG_COMPRESSION)) {
+		struct cbfs_media media;
+		if (cbfs_index_media(&media, region))
+			return NULL;
+		void *content = cbfs_get_file_content(&media, name, type, sz);
+		media.close(&media);
+		return content;
+	}
+
+	uint32_t len = ntohl(file->len);
+	void *content = malloc(len);
+	if (!content) {
+		printf("Couldn't allocate %u bytes for '%s'.\n", len, name);
+		return NULL;
+	}
+	memcpy(content, CBFS_SUBHEADER(file), len);
+	if (sz)
+		*sz = len;
+	return content;
+}
+
+int cbfs_index_list(const char *region)
+{
+	CbfsIndex *index = cbfs_index_get(region);
+
+	if (!index || !index->count)
+		return -1;
+
+	printf("%-32s %10s %10s %10s\n", "Name", "Offset", "Type", "Size");
+	for (int i = 0; i < index->count; i++) {
+		CbfsIndexEntry *entry = &index->entries[i];
+		printf("%-32s 0x%08x 0x%08x %10u\n",
+		       entry->name[0] ? entry->name : "(empty)",
+		       entry->offset, entry->type, entry->len);
+	}
+	return 0;
+}
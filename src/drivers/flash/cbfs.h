@@ -18,6 +18,22 @@
 #ifndef __DRIVERS_FLASH_CBFS_H__
 #define __DRIVERS_FLASH_CBFS_H__
 
+#include <cbfs.h>
+#include <stddef.h>
+
 int cbfs_media_from_fmap(struct cbfs_media *media, const char *name);
 
+/*
+ * Like libpayload's cbfs_get_file() and cbfs_get_file_content(), but looked
+ * up in an index of the CBFS in FMAP area region, or of the default CBFS if
+ * region is NULL. The index is built the first time a CBFS is searched.
+ * Content is returned in a buffer the caller has to free.
+ */
+struct cbfs_file *cbfs_index_get_file(const char *region, const char *name);
+void *cbfs_index_get_file_content(const char *region, const char *name,
+				  int type, size_t *sz);
+
+// Print the files in a CBFS. Returns non-zero if it couldn't be indexed.
+int cbfs_index_list(const char *region);
+
 #endif
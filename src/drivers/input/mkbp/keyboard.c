@@ -39,7 +39,47 @@ typedef enum Modifier {
 	ModifierShift = 0x4
 } Modifier;
 
-// Returns amount of scanned keys, or -1 if EC's buffer is known to be empty.
+// Whether the EC reports key matrix changes through its MKBP event FIFO.
+static int use_events = 1;
+
+// Fetches the next key matrix state from the EC. Returns 1 if it came from
+// the EC's event FIFO, 0 if it was a plain matrix scan, and -1 if the EC is
+// known to have nothing new.
+static int read_matrix(struct cros_ec_keyscan *scan)
+{
+	// If the EC doesn't assert its interrupt line, it has no more states.
+	if (!cros_ec_interrupt_pending())
+		return -1;
+
+	while (use_events) {
+		struct ec_response_get_next_event event;
+
+		int res = cros_ec_get_next_event(&event);
+		if (res == -EC_RES_INVALID_COMMAND) {
+			printf("mkbp: No event support, scanning key matrix.\n");
+			use_events = 0;
+			break;
+		}
+		if (res < 0)
+			return -1;
+
+		// Skip over events which aren't for us.
+		if (event.event_type != EC_MKBP_EVENT_KEY_MATRIX)
+			continue;
+
+		memcpy(scan->data, event.data.key_matrix, sizeof(scan->data));
+		return 1;
+	}
+
+	if (cros_ec_scan_keyboard(scan)) {
+		printf("Key matrix scan failed.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Returns amount of new keys, or -1 if EC's buffer is known to be empty.
 static int read_scancodes(Modifier *modifiers, uint8_t *codes, int max_codes)
 {
 	static struct cros_ec_keyscan last_scan;
@@ -48,14 +88,9 @@ static int read_scancodes(Modifier *modifiers, uint8_t *codes, int max_codes)
 	assert(modifiers);
 	*modifiers = ModifierNone;
 
-	// If the EC doesn't assert its interrupt line, it has no more states.
-	if (!cros_ec_interrupt_pending())
-		return -1;
-
-	if (cros_ec_scan_keyboard(&scan)) {
-		printf("Key matrix scan failed.\n");
+	int from_fifo = read_matrix(&scan);
+	if (from_fifo < 0)
 		return -1;
-	}
 
 	int total = 0;
 	int changed = 0;
@@ -69,10 +104,18 @@ static int read_scancodes(Modifier *modifiers, uint8_t *codes, int max_codes)
 		uint8_t row;
 		uint8_t col;
 		uint8_t code;
+		uint8_t held;
 	} Key;
 
 	Key keys[num_keys];
 
+	// Which columns are pressed in each row and vice versa.
+	assert(rows <= 32 && cols <= 32);
+	uint32_t row_cols[rows];
+	uint32_t col_rows[cols];
+	memset(row_cols, 0, sizeof(row_cols));
+	memset(col_rows, 0, sizeof(col_rows));
+
 	for (int pos = 0; pos < num_keys; pos += 8) {
 		int byte = pos / 8;
 
@@ -104,52 +147,43 @@ static int read_scancodes(Modifier *modifiers, uint8_t *codes, int max_codes)
 				if (code == 0x2a || code == 0x36)
 					*modifiers |= ModifierShift;
 
-				// Ignore keys that were already pressed.
-				if ((last_data >> i) & 0x1)
-					code = 0xffff;
+				row_cols[row] |= 1 << col;
+				col_rows[col] |= 1 << row;
 
 				keys[total].row = row;
 				keys[total].col = col;
 				keys[total].code = code;
+				// Ignore keys that were already pressed.
+				keys[total].held = (last_data >> i) & 0x1;
 				total++;
-				if (total == max_codes)
-					break;
 			}
 		}
-		if (total == max_codes)
-			break;
 	}
 
-	// The EC only resends the same state if its FIFO was empty.
+	// The EC only resends the same state if its FIFO was empty. States
+	// from the event FIFO are always new, even if they look the same.
 	if (!changed)
-		return -1;
+		return from_fifo ? 0 : -1;
 
-	// If there could be ghosting, throw everything away. Also, transfer
-	// valid keycodes into the buffer.
+	// If there could be ghosting, throw everything away. That's the case
+	// if a key shares its row with one key and its column with another.
 	for (int i = 0; i < total; i++) {
-		int row_match = 0;
-		int col_match = 0;
+		uint32_t row_bit = 1 << keys[i].row;
+		uint32_t col_bit = 1 << keys[i].col;
 
-		for (int j = 0; j < total; j++) {
-			if (i == j)
-				continue;
-			if (keys[i].row == keys[j].row) {
-				row_match = 1;
-				if (col_match)
-					return 0;
-			}
-			if (keys[i].col == keys[j].col) {
-				col_match = 1;
-				if (row_match)
-					return 0;
-			}
-		}
-
-		if (keys[i].code != 0xffff)
-			*codes++ = keys[i].code;
+		if ((row_cols[keys[i].row] & ~col_bit) &&
+		    (col_rows[keys[i].col] & ~row_bit))
+			return 0;
 	}
 
-	return total;
+	// Transfer valid keycodes into the buffer. The whole matrix is always
+	// scanned so last_scan and the modifiers stay complete.
+	int count = 0;
+	for (int i = 0; i < total && count < max_codes; i++)
+		if (!keys[i].held)
+			codes[count++] = keys[i].code;
+
+	return count;
 }
 
 enum {
@@ -182,9 +216,11 @@ static void more_keys(void)
 	uint8_t scancodes[KeyFifoSize];
 	Modifier modifiers;
 
-	// Keep searching through states until we find a valid key press.
-	while (!fifo_size) {
-		int count = read_scancodes(&modifiers, scancodes, KeyFifoSize);
+	// Keep searching through states until we find a valid key press. If
+	// the EC has queued up more states, take as many as will fit.
+	while (fifo_size < KeyFifoSize) {
+		int count = read_scancodes(&modifiers, scancodes,
+					   KeyFifoSize - fifo_size);
 		if (count < 0)
 			return;	// EC has no more key states buffered.
 
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * A polled virtio network driver. The receive queue is kept stocked with
+ * buffers so the device can deliver a burst of frames without waiting for
+ * us, and consumed buffers are handed back in batches. Transmitted frames
+ * are copied into one of a pool of buffers which is only reclaimed lazily, so
+ * sends don't wait for the device to finish.
+ */
+
+#include <libpayload.h>
+
+#include "base/cleanup_funcs.h"
+#include "base/container_of.h"
+#include "base/init_funcs.h"
+#include "base/list.h"
+#include "drivers/bus/virtio/virtio.h"
+#include "drivers/net/net.h"
+
+enum {
+	VirtioNetFMac = 1 << 5,
+	VirtioNetFMrgRxbuf = 1 << 15,
+	VirtioNetFStatus = 1 << 16
+};
+
+enum {
+	VirtioNetConfigMac = 0,
+	VirtioNetConfigStatus = 6
+};
+
+enum {
+	VirtioNetSLinkUp = 1 << 0
+};
+
+enum {
+	VirtioNetRxQueue = 0,
+	VirtioNetTxQueue = 1
+};
+
+enum {
+	// Every buffer is a header descriptor and a frame descriptor.
+	VirtioNetQueueSize = 128,
+	VirtioNetRxBuffers = 32,
+	VirtioNetTxBuffers = 32,
+	// Hand receive buffers back once this many have been used up.
+	VirtioNetRxRefill = VirtioNetRxBuffers / 4,
+	VirtioNetMaxFrame = 1536,
+	VirtioNetTxTimeoutUs = 1000 * 1000
+};
+
+typedef struct {
+	// Only the legacy header without MRG_RXBUF is shorter than this.
+	uint8_t hdr[12];
+	uint8_t frame[VirtioNetMaxFrame];
+} VirtioNetBuf;
+
+typedef struct {
+	NetDevice net_dev;
+	VirtioDevOps *virtio;
+	uint64_t features;
+	uint32_t hdr_len;
+
+	VirtQueue rxq;
+	VirtQueue txq;
+	VirtioNetBuf *rx_bufs;
+	VirtioNetBuf *tx_bufs;
+	// Transmit buffers the device has handed back.
+	VirtioNetBuf *tx_free[VirtioNetTxBuffers];
+	int tx_num_free;
+
+	uip_eth_addr mac_addr;
+	CleanupFunc cleanup;
+} VirtioNet;
+
+static int virtio_net_post_rx(VirtioNet *net, VirtioNetBuf *buf)
+{
+	VirtQueueBuf bufs[] = {
+		{ buf->hdr, net->hdr_len },
+		{ buf->frame, sizeof(buf->frame) }
+	};
+
+	return virtio_queue_add(&net->rxq, bufs, 0, ARRAY_SIZE(bufs), buf);
+}
+
+static int virtio_net_ready(NetDevice *dev, int *ready)
+{
+	VirtioNet *net = container_of(dev, VirtioNet, net_dev);
+
+	if (!(net->features & VirtioNetFStatus)) {
+		*ready = 1;
+		return 0;
+	}
+
+	uint16_t status;
+	net->virtio->read_config(net->virtio, VirtioNetConfigStatus, &status,
+				 sizeof(status));
+	*ready = !!(status & VirtioNetSLinkUp);
+	return 0;
+}
+
+static int virtio_net_recv(NetDevice *dev, void *buf, uint16_t *len,
+			   int maxlen)
+{
+	VirtioNet *net = container_of(dev, VirtioNet, net_dev);
+	uint32_t used_len;
+
+	*len = 0;
+
+	VirtioNetBuf *rx = virtio_queue_get_used(&net->rxq, &used_len);
+	if (!rx) {
+		// Nothing's waiting, so make sure the device has everything.
+		virtio_queue_kick(&net->rxq);
+		return 0;
+	}
+
+	if (used_len > net->hdr_len) {
+		uint32_t frame_len = used_len - net->hdr_len;
+		if (frame_len > (uint32_t)maxlen) {
+			printf("virtio-net: Dropping %d byte frame.\n",
+			       frame_len);
+		} else {
+			memcpy(buf, rx->frame, frame_len);
+			*len = frame_len;
+		}
+	}
+
+	if (virtio_net_post_rx(net, rx)) {
+		printf("virtio-net: Failed to repost receive buffer.\n");
+		return 1;
+	}
+	if (net->rxq.num_added >= VirtioNetRxRefill)
+		virtio_queue_kick(&net->rxq);
+
+	return 0;
+}
+
+static int virtio_net_send(NetDevice *dev, void *buf, uint16_t len)
+{
+	VirtioNet *net = container_of(dev, VirtioNet, net_dev);
+
+	if (len > VirtioNetMaxFrame) {
+		printf("virtio-net: Frame of %d bytes is too big.\n", len);
+		return 1;
+	}
+
+	VirtioNetBuf *done;
+	while ((done = virtio_queue_get_used(&net->txq, NULL)))
+		net->tx_free[net->tx_num_free++] = done;
+
+	if (!net->tx_num_free) {
+		uint64_t start = timer_us(0);
+		while (!(done = virtio_queue_get_used(&net->txq, NULL))) {
+			if (timer_us(start) > VirtioNetTxTimeoutUs) {
+				printf("virtio-net: Transmit timed out.\n");
+				return 1;
+			}
+		}
+		net->tx_free[net->tx_num_free++] = done;
+	}
+
+	VirtioNetBuf *tx = net->tx_free[--net->tx_num_free];
+	memcpy(tx->frame, buf, len);
+
+	VirtQueueBuf bufs[] = {
+		{ tx->hdr, net->hdr_len },
+		{ tx->frame, len }
+	};
+	if (virtio_queue_add(&net->txq, bufs, ARRAY_SIZE(bufs), 0, tx)) {
+		printf("virtio-net: Transmit queue full.\n");
+		net->tx_free[net->tx_num_free++] = tx;
+		return 1;
+	}
+
+	virtio_queue_kick(&net->txq);
+	return 0;
+}
+
+static const uip_eth_addr *virtio_net_get_mac(NetDevice *dev)
+{
+	VirtioNet *net = container_of(dev, VirtioNet, net_dev);
+
+	return &net->mac_addr;
+}
+
+static int virtio_net_shutdown(CleanupFunc *cleanup, CleanupType type)
+{
+	VirtioNet *net = cleanup->data;
+
+	// Stop the device before its buffers are reused.
+	virtio_reset(net->virtio);
+	return 0;
+}
+
+static int virtio_net_init(VirtioNet *net)
+{
+	VirtioDevOps *virtio = net->virtio;
+
+	if (virtio_start(virtio, VirtioNetFMac | VirtioNetFStatus,
+			 &net->features))
+		return 1;
+
+	net->hdr_len = 10;
+	if (net->features & (VIRTIO_F_VERSION_1 | VirtioNetFMrgRxbuf))
+		net->hdr_len = 12;
+
+	if (net->features & VirtioNetFMac) {
+		virtio->read_config(virtio, VirtioNetConfigMac, &net->mac_addr,
+				    sizeof(net->mac_addr));
+	} else {
+		// Locally administered, with QEMU's usual suffix.
+		static const uip_eth_addr mac = {
+			{ 0x02, 0x00, 0x00, 0x12, 0x34, 0x56 }
+		};
+		net->mac_addr = mac;
+	}
+
+	if (virtio_queue_init(virtio, &net->rxq, VirtioNetRxQueue,
+			      VirtioNetQueueSize) ||
+	    virtio_queue_init(virtio, &net->txq, VirtioNetTxQueue,
+			      VirtioNetQueueSize)) {
+		virtio->set_status(virtio, VirtioStatusFailed);
+		return 1;
+	}
+
+	net->rx_bufs = dma_memalign(sizeof(uint64_t),
+				    sizeof(*net->rx_bufs) * VirtioNetRxBuffers);
+	net->tx_bufs = dma_memalign(sizeof(uint64_t),
+				    sizeof(*net->tx_bufs) * VirtioNetTxBuffers);
+	if (!net->rx_bufs || !net->tx_bufs) {
+		printf("virtio-net: Failed to allocate buffers.\n");
+		virtio->set_status(virtio, VirtioStatusFailed);
+		return 1;
+	}
+	memset(net->tx_bufs, 0, sizeof(*net->tx_bufs) * VirtioNetTxBuffers);
+	for (int i = 0; i < VirtioNetTxBuffers; i++)
+		net->tx_free[net->tx_num_free++] = &net->tx_bufs[i];
+
+	for (int i = 0; i < VirtioNetRxBuffers; i++) {
+		if (virtio_net_post_rx(net, &net->rx_bufs[i]))
+			break;
+	}
+
+	virtio_driver_ok(virtio);
+	virtio_queue_kick(&net->rxq);
+
+	net->cleanup.cleanup = &virtio_net_shutdown;
+	net->cleanup.types = CleanupOnHandoff | CleanupOnLegacy;
+	net->cleanup.data = net;
+	list_insert_after(&net->cleanup.list_node, &cleanup_funcs);
+
+	net->net_dev.ready = &virtio_net_ready;
+	net->net_dev.recv = &virtio_net_recv;
+	net->net_dev.send = &virtio_net_send;
+	net->net_dev.get_mac = &virtio_net_get_mac;
+	net_add_device(&net->net_dev);
+
+	printf("Added virtio-net device %02x:%02x:%02x:%02x:%02x:%02x.\n",
+	       net->mac_addr.addr[0], net->mac_addr.addr[1],
+	       net->mac_addr.addr[2], net->mac_addr.addr[3],
+	       net->mac_addr.addr[4], net->mac_addr.addr[5]);
+	return 0;
+}
+
+static void virtio_net_poller(NetPoller *poller)
+{
+	static int initted;
+	if (initted)
+		return;
+	initted = 1;
+
+	VirtioDevOps *virtio;
+	list_for_each(virtio, virtio_devices, list_node) {
+		if (virtio->device_id != VirtioIdNet)
+			continue;
+
+		VirtioNet *net = xzalloc(sizeof(*net));
+		net->virtio = virtio;
+		if (virtio_net_init(net))
+			free(net);
+	}
+}
+
+static NetPoller net_poller = {
+	.poll = &virtio_net_poller
+};
+
+static int virtio_net_driver_register(void)
+{
+	list_insert_after(&net_poller.list_node, &net_pollers);
+	return 0;
+}
+
+INIT_FUNC(virtio_net_driver_register);
@@ -102,7 +102,7 @@ static void busmaster_disable(void)
  */
 static int pch_power_off_full_args(pcidev_t pci_dev, int pmbase_reg,
 					uint16_t bar_mask, uint16_t gpe_en_reg,
-					int num_gpe_regs)
+					int num_gpe_regs, uint32_t slp_typ)
 {
 	int i;
 
@@ -139,7 +139,7 @@ static int pch_power_off_full_args(pcidev_t pci_dev, int pmbase_reg,
 
 	// Set Sleeping Type to S5 (poweroff).
 	reg32 &= ~(SLP_EN | SLP_TYP);
-	reg32 |= SLP_TYP_S5;
+	reg32 |= slp_typ;
 	outl(reg32, pmbase + PM1_CNT);
 
 	// Now set the Sleep Enable bit.
@@ -152,7 +152,7 @@ static int pch_power_off_full_args(pcidev_t pci_dev, int pmbase_reg,
 static int pch_power_off_common(uint16_t bar_mask, uint16_t gpe_en_reg)
 {
 	return pch_power_off_full_args(PCI_DEV(0, 0x1f, 0), 0x40,
-					bar_mask, gpe_en_reg, 1);
+					bar_mask, gpe_en_reg, 1, SLP_TYP_S5);
 }
 
 static int pch_power_off(PowerOps *me)
@@ -175,7 +175,15 @@ static int skylake_power_off(PowerOps *me)
 	// Skylake has 4 GPE en registers and the bar lives within the
 	// PMC device at 0:1f.2.
 	return pch_power_off_full_args(PCI_DEV(0, 0x1f, 2), 0x40,
-					0xfff0, 0x90, 4);
+					0xfff0, 0x90, 4, SLP_TYP_S5);
+}
+
+static int qemu_q35_power_off(PowerOps *me)
+{
+	// QEMU's emulated ICH9 treats sleep type 0 as soft off, which is
+	// what its ACPI tables advertise for S5.
+	return pch_power_off_full_args(PCI_DEV(0, 0x1f, 0), 0x40,
+					0xff80, 0x28, 1, SLP_TYP_S0);
 }
 
 PowerOps pch_power_ops = {
@@ -197,3 +205,8 @@ PowerOps skylake_power_ops = {
 	.cold_reboot = &pch_cold_reboot,
 	.power_off = &skylake_power_off
 };
+
+PowerOps qemu_q35_power_ops = {
+	.cold_reboot = &pch_cold_reboot,
+	.power_off = &qemu_q35_power_off
+};
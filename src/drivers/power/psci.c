@@ -0,0 +1,52 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but without any warranty; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "drivers/power/psci.h"
+
+enum {
+	PSCI_SYSTEM_OFF = 0x84000008,
+	PSCI_SYSTEM_RESET = 0x84000009
+};
+
+static void psci_call(uint32_t function)
+{
+	register uint64_t x0 asm("x0") = function;
+
+	// SMCCC lets the firmware clobber x1-x17.
+	asm volatile("smc #0" : "+r" (x0) :
+		     : "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
+		       "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17",
+		       "memory");
+}
+
+static int psci_cold_reboot(PowerOps *me)
+{
+	psci_call(PSCI_SYSTEM_RESET);
+	printf("PSCI system reset failed.\n");
+	halt();
+}
+
+static int psci_power_off(PowerOps *me)
+{
+	psci_call(PSCI_SYSTEM_OFF);
+	printf("PSCI system off failed.\n");
+	halt();
+}
+
+PowerOps psci_power_ops = {
+	.cold_reboot = &psci_cold_reboot,
+	.power_off = &psci_power_off
+};
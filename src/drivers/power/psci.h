@@ -0,0 +1,23 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but without any warranty; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DRIVERS_POWER_PSCI_H__
+#define __DRIVERS_POWER_PSCI_H__
+
+#include "drivers/power/power.h"
+
+/* Reboot or power off through the PSCI firmware interface using SMC. */
+extern PowerOps psci_power_ops;
+
+#endif /* __DRIVERS_POWER_PSCI_H__ */
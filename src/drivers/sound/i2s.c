@@ -31,8 +31,13 @@
 #include "drivers/bus/i2s/i2s.h"
 #include "drivers/sound/i2s.h"
 
-// Generates square wave sound data for 1 second.
-static void sound_square_wave(uint16_t *data, int channels,
+enum {
+	// Shortest looping buffer handed to the I2S controller's DMA.
+	I2sLoopMinMsec = 20
+};
+
+// Generates the given number of samples of square wave sound data.
+static void sound_square_wave(uint16_t *data, int channels, int samples,
 			      int sample_rate, uint32_t freq, uint16_t volume)
 {
 	assert(freq);
@@ -40,8 +45,6 @@ static void sound_square_wave(uint16_t *data, int channels,
 	const int period = sample_rate / freq;
 	const int half = period / 2;
 
-	int samples = sample_rate;
-
 	while (samples) {
 		for (int i = 0; samples && i < half; samples--, i++) {
 			for (int j = 0; j < channels; j++)
@@ -71,8 +74,8 @@ static int i2s_source_play(SoundOps *me, uint32_t msec, uint32_t frequency)
 	int bytes = sample_rate * channels * sizeof(uint16_t);
 	uint32_t *data = xmalloc(bytes);
 
-	sound_square_wave((uint16_t *)data, channels, sample_rate, frequency,
-			  source->volume);
+	sound_square_wave((uint16_t *)data, channels, sample_rate,
+			  sample_rate, frequency, source->volume);
 
 	uint64_t start = timer_us(0);
 
@@ -98,11 +101,62 @@ static int i2s_source_play(SoundOps *me, uint32_t msec, uint32_t frequency)
 	return 0;
 }
 
+static int i2s_source_start(SoundOps *me, uint32_t frequency)
+{
+	I2sSource *source = container_of(me, I2sSource, ops);
+
+	if (!source->i2s->start_loop || !source->i2s->stop)
+		return -1;
+
+	const int channels = source->channels;
+	const int sample_rate = source->sample_rate;
+
+	if (!frequency || frequency > sample_rate / 2)
+		return 1;
+
+	/*
+	 * The buffer is a whole number of periods long so the wave stays
+	 * continuous as the DMA wraps around. It's kept around since the
+	 * same tone tends to be started over and over again.
+	 */
+	if (!source->loop_data || source->loop_frequency != frequency) {
+		const int period = sample_rate / frequency;
+		int min_samples = sample_rate * I2sLoopMinMsec / 1000;
+		int samples = (min_samples + period - 1) / period * period;
+		// The controller is fed whole 32 bit words.
+		if ((samples * channels) % 2)
+			samples *= 2;
+		int bytes = samples * channels * sizeof(uint16_t);
+
+		free(source->loop_data);
+		source->loop_data = xmalloc(bytes);
+		sound_square_wave((uint16_t *)source->loop_data, channels,
+				  samples, sample_rate, frequency,
+				  source->volume);
+		source->loop_length = bytes / sizeof(uint32_t);
+		source->loop_frequency = frequency;
+	}
+
+	return source->i2s->start_loop(source->i2s, source->loop_data,
+				       source->loop_length);
+}
+
+static int i2s_source_stop(SoundOps *me)
+{
+	I2sSource *source = container_of(me, I2sSource, ops);
+
+	if (!source->i2s->stop)
+		return -1;
+	return source->i2s->stop(source->i2s);
+}
+
 I2sSource *new_i2s_source(I2sOps *i2s, int sample_rate, int channels,
 			  uint16_t volume)
 {
 	I2sSource *source = xzalloc(sizeof(*source));
 
+	source->ops.start = &i2s_source_start;
+	source->ops.stop = &i2s_source_stop;
 	source->ops.play = &i2s_source_play;
 
 	source->i2s = i2s;
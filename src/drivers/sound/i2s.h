@@ -23,6 +23,11 @@ typedef struct
 	int sample_rate;
 	int channels;
 	uint16_t volume;
+
+	// Looping waveform for the last frequency passed to start.
+	uint32_t *loop_data;
+	unsigned int loop_length;
+	uint32_t loop_frequency;
 } I2sSource;
 
 // Assumes 16 bits per sample.
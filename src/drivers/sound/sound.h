@@ -23,6 +23,11 @@ typedef struct SoundOps
 
 void sound_set_ops(SoundOps *ops);
 
+/*
+ * Start a tone which keeps playing in the background until sound_stop() is
+ * called. Returns a negative value if the driver can only play blocking
+ * tones with sound_play().
+ */
 int sound_start(uint32_t frequency);
 int sound_stop(void);
 int sound_play(uint32_t msec, uint32_t frequency);
@@ -20,6 +20,7 @@
  * MA 02111-1307 USA
  */
 
+#include "base/timestamp.h"
 #include "drivers/storage/blockdev.h"
 
 #include <assert.h>
@@ -104,11 +105,17 @@ int get_all_bdevs(blockdev_type_t type, ListNode **bdevs)
 
 	/* Update any controllers that need it. */
 	BlockDevCtrlr *ctrlr;
+	int updated = 0;
 	list_for_each(ctrlr, *ctrlrs, list_node) {
-		if (ctrlr->ops.update && ctrlr->need_update &&
-		    ctrlr->ops.update(&ctrlr->ops))
+		if (!ctrlr->ops.update || !ctrlr->need_update)
+			continue;
+		if (!updated++)
+			timestamp_add_now(TS_STORAGE_UPDATE);
+		if (ctrlr->ops.update(&ctrlr->ops))
 			printf("Updating storage controller failed.\n");
 	}
+	if (updated)
+		timestamp_add_now(TS_STORAGE_UPDATE_DONE);
 
 	/* Count the devices. */
 	for (ListNode *node = devs->next; node; node = node->next, count++)
@@ -27,6 +27,7 @@
 #include <libpayload.h>
 #include <malloc.h>
 
+#include "base/boot_perf.h"
 #include "bouncebuf.h"
 
 // TODO(hungte) Deprecate this file after we've shown the drivers using this
@@ -35,6 +36,27 @@
 
 static int _debug = 0;
 
+enum {
+	// Enough for a transfer on each controller with some to spare.
+	BouncePoolSize = 4,
+	/*
+	 * Transfers into memory this big or bigger are done in place even if
+	 * they don't start or end on a cache line boundary. Smaller ones are
+	 * cheap to copy, and are the ones likely to sit next to live data on
+	 * the stack.
+	 */
+	BounceInPlaceMin = 64 * KiB
+};
+
+typedef struct {
+	void *buf;
+	size_t size;
+	int busy;
+} BouncePoolBuf;
+
+// Buffers are kept from one transfer to the next and only ever grow.
+static BouncePoolBuf bounce_pool[BouncePoolSize];
+
 static int addr_aligned(struct bounce_buffer *state)
 {
 	const uint32_t align_mask = ARCH_DMA_MINALIGN - 1;
@@ -58,6 +80,80 @@ static int addr_aligned(struct bounce_buffer *state)
 	return 1;
 }
 
+/*
+ * Whether the controller can work on the caller's buffer directly even
+ * though it shares cache lines with its neighbours.
+ *
+ * When the device only reads the buffer, cleaning those lines is all it
+ * takes, whatever the CPU does to the neighbours in the meantime. When the
+ * device writes the buffer, the head and tail lines are cleaned and
+ * invalidated up front and invalidated again once the data has landed.
+ * Everything in between is never copied. Callers must not write the bytes
+ * sharing the first and last line until bounce_buffer_stop(): a line the CPU
+ * dirties in the meantime can be written back over the DMA'd data, and the
+ * final invalidate throws the CPU's write away.
+ */
+static int in_place_ok(struct bounce_buffer *state)
+{
+	if ((uintptr_t)state->user_buffer & (ARCH_DMA_ADDR_ALIGN - 1))
+		return 0;
+
+	if (!(state->flags & GEN_BB_WRITE))
+		return 1;
+
+	return state->len >= BounceInPlaceMin;
+}
+
+static void *bounce_pool_get(struct bounce_buffer *state)
+{
+	BouncePoolBuf *fit = NULL, *spare = NULL;
+
+	for (int i = 0; i < BouncePoolSize; i++) {
+		BouncePoolBuf *pool_buf = &bounce_pool[i];
+
+		if (pool_buf->busy)
+			continue;
+		if (pool_buf->size >= state->len_aligned) {
+			if (!fit || pool_buf->size < fit->size)
+				fit = pool_buf;
+		} else if (!spare || pool_buf->size < spare->size) {
+			spare = pool_buf;
+		}
+	}
+
+	if (!fit && spare) {
+		// Grow the smallest buffer which is too small anyway.
+		free(spare->buf);
+		spare->buf = memalign(ARCH_DMA_MINALIGN, state->len_aligned);
+		spare->size = spare->buf ? state->len_aligned : 0;
+		if (spare->buf)
+			fit = spare;
+	}
+
+	if (!fit)
+		return NULL;
+
+	fit->busy = 1;
+	state->pool_index = fit - bounce_pool;
+	return fit->buf;
+}
+
+static void cache_clean_invalidate(void *buf, size_t len)
+{
+	uintptr_t start = ALIGN_DOWN((uintptr_t)buf, ARCH_DMA_MINALIGN);
+	uintptr_t end = ALIGN_UP((uintptr_t)buf + len, ARCH_DMA_MINALIGN);
+
+	dcache_clean_invalidate_by_mva((void *)start, end - start);
+}
+
+static void cache_invalidate(void *buf, size_t len)
+{
+	uintptr_t start = ALIGN_DOWN((uintptr_t)buf, ARCH_DMA_MINALIGN);
+	uintptr_t end = ALIGN_UP((uintptr_t)buf + len, ARCH_DMA_MINALIGN);
+
+	dcache_invalidate_by_mva((void *)start, end - start);
+}
+
 int bounce_buffer_start(struct bounce_buffer *state, void *data,
 			size_t len, unsigned int flags)
 {
@@ -66,12 +162,16 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 	state->len = len;
 	state->len_aligned = ROUND(len, ARCH_DMA_MINALIGN);
 	state->flags = flags;
+	state->pool_index = -1;
 
-	if (!addr_aligned(state)) {
-		state->bounce_buffer = memalign(ARCH_DMA_MINALIGN,
-						state->len_aligned);
+	if (!addr_aligned(state) && !in_place_ok(state)) {
+		state->bounce_buffer = bounce_pool_get(state);
+		if (!state->bounce_buffer)
+			state->bounce_buffer = memalign(ARCH_DMA_MINALIGN,
+							state->len_aligned);
 		if (!state->bounce_buffer)
 			return -1;
+		boot_perf_add(BootPerfBounceBytes, state->len);
 
 		if (state->flags & GEN_BB_READ)
 			memcpy(state->bounce_buffer, state->user_buffer,
@@ -82,8 +182,7 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 	 * Flush data to RAM so DMA reads can pick it up,
 	 * and any CPU writebacks don't race with DMA writes
 	 */
-        dcache_clean_invalidate_by_mva(state->bounce_buffer,
-                                       state->len_aligned);
+	cache_clean_invalidate(state->bounce_buffer, state->len);
 	return 0;
 }
 
@@ -91,8 +190,7 @@ int bounce_buffer_stop(struct bounce_buffer *state)
 {
 	if (state->flags & GEN_BB_WRITE) {
 		// Invalidate cache so that CPU can see any newly DMA'd data
-		dcache_invalidate_by_mva(state->bounce_buffer,
-					 state->len_aligned);
+		cache_invalidate(state->bounce_buffer, state->len);
 	}
 
 	if (state->bounce_buffer == state->user_buffer)
@@ -101,7 +199,10 @@ int bounce_buffer_stop(struct bounce_buffer *state)
 	if (state->flags & GEN_BB_WRITE)
 		memcpy(state->user_buffer, state->bounce_buffer, state->len);
 
-	free(state->bounce_buffer);
+	if (state->pool_index >= 0)
+		bounce_pool[state->pool_index].busy = 0;
+	else
+		free(state->bounce_buffer);
 
 	return 0;
 }
@@ -43,7 +43,9 @@
  * The source buffer starts in an undefined state upon start() call, then the
  * operation requiring the aligned transfer happens, then the bounce buffer is
  * copied into the destination buffer (if unaligned, otherwise destination
- * buffer is used directly) upon stop() call.
+ * buffer is used directly) upon stop() call. Large transfers into unaligned
+ * buffers may be done in place, so the bytes sharing the buffer's first and
+ * last cache lines must not be written until stop().
  */
 #define GEN_BB_WRITE	(1 << 1)
 /*
@@ -61,8 +63,8 @@ struct bounce_buffer {
 	void *user_buffer;
 	/*
 	 * DMA-aligned buffer. This field is always set to the value that
-	 * should be used for DMA; either equal to .user_buffer, or to a
-	 * freshly allocated aligned buffer.
+	 * should be used for DMA; either equal to .user_buffer, or to an
+	 * aligned buffer from a pool kept for the purpose.
 	 */
 	void *bounce_buffer;
 	/* Copy of len parameter passed to start() */
@@ -71,6 +73,8 @@ struct bounce_buffer {
 	size_t len_aligned;
 	/* Copy of flags parameter passed to start() */
 	unsigned int flags;
+	/* Index of the pool buffer in use, or -1 */
+	int pool_index;
 };
 
 /**
@@ -100,5 +104,9 @@ int bounce_buffer_stop(struct bounce_buffer *state);
 #ifndef ARCH_DMA_MINALIGN
 #define ARCH_DMA_MINALIGN (DMA_MINALIGN)
 #endif
+// The alignment the DMA engines themselves need, as opposed to the cache.
+#ifndef ARCH_DMA_ADDR_ALIGN
+#define ARCH_DMA_ADDR_ALIGN (4)
+#endif
 
 #endif // __DRIVERS_STORAGE_BOUNCEBUF_H__
@@ -30,6 +30,7 @@
 #include <libpayload.h>
 #include <stdint.h>
 
+#include "base/boot_perf.h"
 #include "config.h"
 #include "drivers/storage/mmc.h"
 
@@ -142,6 +143,8 @@ static int mmc_send_cmd(MmcCtrlr *ctrlr, MmcCommand *cmd, MmcData *data)
 		/* Retry failed data commands, bail out otherwise.  */
 		if (!data || !ret)
 			break;
+		if (retries)
+			boot_perf_add(BootPerfStorageRetries, 1);
 	}
 	return ret;
 }
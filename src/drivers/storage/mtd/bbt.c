@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "drivers/storage/mtd/mtd.h"
+
+/*
+ * Finding out if a block is bad costs a page read on most parts, so the
+ * answer for each block is kept in two bits once it's known. Blocks are
+ * filled in as they're asked about, since scanning the whole device up front
+ * would cost more than the handful of blocks a boot touches.
+ */
+enum {
+	BbtUnknown = 0,
+	BbtGood = 1,
+	BbtBad = 2,
+	BbtMask = 3,
+	BbtBlocksPerByte = 4
+};
+
+static int bbt_get(MtdDev *mtd, uint32_t block)
+{
+	int shift = (block % BbtBlocksPerByte) * 2;
+
+	return (mtd->bbt[block / BbtBlocksPerByte] >> shift) & BbtMask;
+}
+
+static void bbt_set(MtdDev *mtd, uint32_t block, int state)
+{
+	int shift = (block % BbtBlocksPerByte) * 2;
+	uint8_t *entry = &mtd->bbt[block / BbtBlocksPerByte];
+
+	*entry = (*entry & ~(BbtMask << shift)) | (state << shift);
+}
+
+static int bbt_check(MtdDev *mtd, uint64_t ofs)
+{
+	if (ofs >= mtd->size || (ofs & (mtd->erasesize - 1)))
+		return -EINVAL;
+
+	if (!mtd->bbt) {
+		uint32_t blocks = mtd->size / mtd->erasesize;
+		mtd->bbt = xzalloc((blocks + BbtBlocksPerByte - 1) /
+				   BbtBlocksPerByte);
+	}
+	return 0;
+}
+
+int mtd_block_isbad(MtdDev *mtd, uint64_t ofs)
+{
+	int ret = bbt_check(mtd, ofs);
+	if (ret)
+		return ret;
+
+	uint32_t block = ofs / mtd->erasesize;
+	int state = bbt_get(mtd, block);
+	if (state != BbtUnknown)
+		return state == BbtBad;
+
+	// Errors aren't remembered, so the next caller tries again.
+	ret = mtd->block_isbad(mtd, ofs);
+	if (ret < 0)
+		return ret;
+
+	bbt_set(mtd, block, ret ? BbtBad : BbtGood);
+	return ret;
+}
+
+void mtd_block_forget(MtdDev *mtd, uint64_t ofs)
+{
+	if (bbt_check(mtd, ofs))
+		return;
+
+	bbt_set(mtd, ofs / mtd->erasesize, BbtUnknown);
+}
@@ -161,9 +161,23 @@ typedef struct MtdDev {
 	/* ECC status information */
 	struct mtd_ecc_stats ecc_stats;
 
+	/* Bad block table, see mtd_block_isbad(). */
+	uint8_t *bbt;
+
 	void *priv;
 } MtdDev;
 
+/*
+ * Whether the erase block at ofs is bad, like block_isbad, but each block is
+ * only looked up on the device once and remembered after that.
+ */
+int mtd_block_isbad(MtdDev *mtd, uint64_t ofs);
+/*
+ * Drop what's known about the erase block at ofs, for when its bad block
+ * marker may have changed, like after a scrubbing erase.
+ */
+void mtd_block_forget(MtdDev *mtd, uint64_t ofs);
+
 typedef struct MtdDevCtrlr {
 	MtdDev *dev;
 	int (*update)(struct MtdDevCtrlr *me);
@@ -1059,7 +1059,6 @@ static int bcm_nand_erase(MtdDev *mtd, struct erase_info *instr)
 	uint64_t offs = instr->addr;
 	uint64_t size = instr->len;
 	int ret;
-	int bad_block;
 
 	debug("%s 0x%llx [0x%llx]\n", __func__, offs, size);
 
@@ -1073,17 +1072,19 @@ static int bcm_nand_erase(MtdDev *mtd, struct erase_info *instr)
 		return -EINVAL;
 
 	while (size > 0) {
-		ret = nand_block_isbad(offs, &bad_block);
+		ret = mtd_block_isbad(mtd, offs);
 		if (ret < 0) {
 			instr->fail_addr = offs;
 			return ret;
 		}
-		if (!instr->scrub && bad_block) {
+		if (!instr->scrub && ret) {
 			printf(DRV_NAME ": cannot erase bad block 0x%llx\n",
 			       offs);
 			return -EIO;
 		}
 		ret = nand_erase_block(offs);
+		if (instr->scrub)
+			mtd_block_forget(mtd, offs);
 		if (ret < 0) {
 			instr->fail_addr = offs;
 			return ret;
@@ -1137,12 +1137,14 @@ static int ipq_nand_erase(MtdDev *mtd, struct erase_info *instr)
 	for (i = start; i < (start + blocks); i++) {
 		offs = i << dev->phys_erase_shift;
 
-		if (!instr->scrub && ipq_nand_block_isbad(mtd, offs)) {
+		if (!instr->scrub && mtd_block_isbad(mtd, offs)) {
 			printf("ipq_nand: attempt to erase a bad block");
 			return -EIO;
 		}
 
 		ret = ipq_nand_erase_block(mtd, i);
+		if (instr->scrub)
+			mtd_block_forget(mtd, offs);
 		if (ret < 0) {
 			instr->fail_addr = offs;
 			break;
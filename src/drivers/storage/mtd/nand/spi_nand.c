@@ -421,6 +421,25 @@ static int spi_nand_write_page(MtdDev *mtd, int pageno, unsigned int length,
 	return 0;
 }
 
+/* Account for the ECC status of a page which is now in the cache. */
+static void spi_nand_check_ecc(MtdDev *mtd, int pageno, int status)
+{
+	unsigned int corrected = 0, ecc_error = 0;
+
+	spi_nand_get_ecc_status(status, &corrected, &ecc_error);
+	mtd->ecc_stats.corrected += corrected;
+
+	/*
+	 * If there's an ECC error, print a message and notify MTD
+	 * about it. Then complete the read, to load actual data on
+	 * the buffer (instead of the status result).
+	 */
+	if (ecc_error) {
+		printf("spi_nand: ECC error reading page %d\n", pageno);
+		mtd->ecc_stats.failed++;
+	}
+}
+
 /*
  * Read a page worth of data and oob.
  */
@@ -430,7 +449,6 @@ static int spi_nand_read_page(MtdDev *mtd, int pageno,
 			      uint8_t *read_buf, int raw)
 {
 	struct spi_nand_dev *dev = MTD_SPI_NAND_DEV(mtd);
-	unsigned int corrected = 0, ecc_error = 0;
 	int ret;
 
 	/* Load a page into the cache register */
@@ -445,21 +463,8 @@ static int spi_nand_read_page(MtdDev *mtd, int pageno,
 	if (ret < 0)
 		return ret;
 
-	if (!raw) {
-		spi_nand_get_ecc_status(ret, &corrected, &ecc_error);
-		mtd->ecc_stats.corrected += corrected;
-
-		/*
-		 * If there's an ECC error, print a message and notify MTD
-		 * about it. Then complete the read, to load actual data on
-		 * the buffer (instead of the status result).
-		 */
-		if (ecc_error) {
-			printf("spi_nand: ECC error reading page %d\n",
-			       pageno);
-			mtd->ecc_stats.failed++;
-		}
-	}
+	if (!raw)
+		spi_nand_check_ecc(mtd, pageno, ret);
 
 	/* Get page from the device cache into our internal buffer */
 	ret = spi_nand_read_cache(dev, page_offset, length, read_buf);
@@ -528,6 +533,36 @@ static void spi_nand_read_datcopy(MtdDev *mtd, struct mtd_oob_ops *ops)
 	ops->retlen += datlen;
 }
 
+/*
+ * Read pages of data with ECC, without OOB. Whole pages go straight into the
+ * caller's buffer rather than through the internal one.
+ */
+static int spi_nand_read_data(MtdDev *mtd, int start, int pages,
+			      struct mtd_oob_ops *ops)
+{
+	struct spi_nand_dev *dev = MTD_SPI_NAND_DEV(mtd);
+	int i, ret;
+
+	for (i = start; i < (start + pages); i++) {
+		int direct = (ops->len - ops->retlen) >= mtd->writesize;
+		uint8_t *buf = direct ? ops->datbuf + ops->retlen :
+					dev->pad_dat;
+
+		spi_nand_debug_poison_buf(buf, mtd->writesize);
+
+		ret = spi_nand_read_page(mtd, i, 0, mtd->writesize, buf, 0);
+		if (ret < 0)
+			return ret;
+
+		if (direct)
+			ops->retlen += mtd->writesize;
+		else
+			spi_nand_read_datcopy(mtd, ops);
+	}
+
+	return 0;
+}
+
 static int spi_nand_read_oob(MtdDev *mtd, uint64_t from,
 			     struct mtd_oob_ops *ops)
 {
@@ -579,22 +614,31 @@ static int spi_nand_read_oob(MtdDev *mtd, uint64_t from,
 
 	corrected = mtd->ecc_stats.corrected;
 
-	for (i = start; i < (start + pages); i++) {
-
-		spi_nand_debug_poison_buf(read_buf, read_len);
-
-		/*
-		 * Read into the internal buffers. Depending on the request
-		 * this reads either: page data plus OOB on pad_dat, page data
-		 * only on pad_dat, or OOB only on pad_oob.
-		 */
-		ret = spi_nand_read_page(mtd, i, read_off, read_len, read_buf,
-					 (ops->mode == MTD_OOB_RAW));
+	/* Plain data reads, like those from spi_nand_read, can be faster. */
+	if (ops->datbuf && !ops->oobbuf && ops->mode != MTD_OOB_RAW) {
+		ret = spi_nand_read_data(mtd, start, pages, ops);
 		if (ret < 0)
 			goto done;
-
-		spi_nand_read_datcopy(mtd, ops);
-		spi_nand_read_oobcopy(mtd, ops);
+	} else {
+		for (i = start; i < (start + pages); i++) {
+
+			spi_nand_debug_poison_buf(read_buf, read_len);
+
+			/*
+			 * Read into the internal buffers. Depending on the
+			 * request this reads either: page data plus OOB on
+			 * pad_dat, raw page data only on pad_dat, or OOB only
+			 * on pad_oob.
+			 */
+			ret = spi_nand_read_page(mtd, i, read_off, read_len,
+						 read_buf,
+						 (ops->mode == MTD_OOB_RAW));
+			if (ret < 0)
+				goto done;
+
+			spi_nand_read_datcopy(mtd, ops);
+			spi_nand_read_oobcopy(mtd, ops);
+		}
 	}
 
 	if (mtd->ecc_stats.corrected != corrected)
@@ -848,7 +892,7 @@ static int spi_nand_erase(MtdDev *mtd, struct erase_info *instr)
 	for (i = start; i < (start + blocks); i++) {
 		offs = i << dev->phys_erase_shift;
 
-		if (!instr->scrub && spi_nand_block_isbad(mtd, offs)) {
+		if (!instr->scrub && mtd_block_isbad(mtd, offs)) {
 			printf("spi_nand: attempt to erase a bad block");
 			return -EIO;
 		}
@@ -861,6 +905,8 @@ static int spi_nand_erase(MtdDev *mtd, struct erase_info *instr)
 		}
 
 		ret = spi_nand_erase_block(mtd, i);
+		if (instr->scrub)
+			mtd_block_forget(mtd, offs);
 		if (ret < 0) {
 			instr->fail_addr = offs;
 			break;
@@ -29,6 +29,9 @@ typedef struct {
 	MtdDev *mtd;
 	uint64_t offset;
 	uint64_t limit;
+	/* The last page read for a partial page request, and where it's from */
+	uint8_t *page_buf;
+	uint64_t page_buf_offset;
 } MtdStream;
 
 typedef struct {
@@ -38,6 +41,40 @@ typedef struct {
 
 #define stream_debug(...) do { if (0) printf(__VA_ARGS__); } while (0)
 
+/* Copy the part of a page a request wants, reading the page only if needed */
+static int read_mtd_stream_partial(MtdStream *mtd_stream, uint64_t count,
+				   uint8_t *buffer)
+{
+	MtdDev *mtd = mtd_stream->mtd;
+	uint64_t page = ALIGN_DOWN(mtd_stream->offset, mtd->writesize);
+
+	if (!mtd_stream->page_buf) {
+		mtd_stream->page_buf = xmalloc(mtd->writesize);
+		mtd_stream->page_buf_offset = ~0ULL;
+	}
+
+	if (mtd_stream->page_buf_offset != page) {
+		size_t retlen;
+		int ret = mtd->read(mtd, page, mtd->writesize, &retlen,
+				    mtd_stream->page_buf);
+		if (ret < 0 && ret != -EUCLEAN) {
+			printf("Read failure!! ret=%d\n", ret);
+			mtd_stream->page_buf_offset = ~0ULL;
+			return ret;
+		}
+		if (retlen != mtd->writesize) {
+			printf("Read failure!! retlen=%zu\n", retlen);
+			mtd_stream->page_buf_offset = ~0ULL;
+			return -EIO;
+		}
+		mtd_stream->page_buf_offset = page;
+	}
+
+	memcpy(buffer, mtd_stream->page_buf + (mtd_stream->offset - page),
+	       count);
+	return 0;
+}
+
 /* returns amount written on success */
 static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 				void *buffer) {
@@ -49,15 +86,6 @@ static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 	MtdDev *mtd = mtd_stream->mtd;
 	assert(mtd != NULL);
 
-	/* TODO(dehrenberg): before any release is made:
-	 * Implement unaligned reads in a generic way, in a buffer managed by
-	 * the general MTD layer. */
-	if (count % mtd->writesize != 0) {
-		printf("misaligned stream read, count=0x%llx, writesize=0x%x",
-		       count, mtd->writesize);
-		return -EINVAL;
-	}
-
 	uint8_t *cur_buffer = buffer;
 	uint64_t remaining = count;
 
@@ -65,8 +93,9 @@ static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 		stream_debug("Iteration 0x%llx 0x%llx 0x%llx %p\n",
 			     remaining, mtd_stream->offset, mtd_stream->limit,
 			     cur_buffer);
-		assert(remaining + mtd_stream->offset <= mtd_stream->limit);
-		if (remaining + mtd_stream->offset == mtd_stream->limit) {
+		/* Skipping a bad block can take offset past the limit. */
+		if (mtd_stream->offset >= mtd_stream->limit ||
+		    remaining > mtd_stream->limit - mtd_stream->offset) {
 			printf(
 			       "read out of bounds remaining=0x%llx offset=0x%llx limit=0x%llx",
 			       remaining, mtd_stream->offset,
@@ -76,7 +105,7 @@ static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 
 		/* Skip a bad block */
 		if (mtd_stream->offset % mtd->erasesize == 0) {
-			if (mtd->block_isbad(mtd, mtd_stream->offset)) {
+			if (mtd_block_isbad(mtd, mtd_stream->offset)) {
 				printf("skipping bad block at 0x%llx\n",
 				       mtd_stream->offset);
 				mtd_stream->offset += mtd->erasesize;
@@ -84,13 +113,30 @@ static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 			}
 		}
 
-		/* Read up to the end of the current erase block or to
-		 * the end of the user request, whichever comes first. */
-		int length = MIN(ALIGN_UP(mtd_stream->offset + 1,
-					  mtd->erasesize),
-				 mtd_stream->offset + remaining)
+		uint64_t page_left = mtd->writesize -
+			mtd_stream->offset % mtd->writesize;
+
+		/* Pieces of pages go through the page buffer. */
+		if (page_left != mtd->writesize || remaining < page_left) {
+			uint64_t length = MIN(page_left, remaining);
+			int ret = read_mtd_stream_partial(mtd_stream, length,
+							  cur_buffer);
+			if (ret < 0)
+				return count - remaining;
+			mtd_stream->offset += length;
+			remaining -= length;
+			cur_buffer += length;
+			continue;
+		}
+
+		/* Read whole pages up to the end of the current erase block
+		 * or to the end of the user request, whichever comes first. */
+		size_t length = MIN(ALIGN_UP(mtd_stream->offset + 1,
+					     mtd->erasesize),
+				    mtd_stream->offset +
+				    ALIGN_DOWN(remaining, mtd->writesize))
 				- mtd_stream->offset;
-		unsigned int retlen;
+		size_t retlen;
 		int ret = mtd->read(mtd, mtd_stream->offset, length, &retlen,
 				    cur_buffer);
 		if (ret < 0 && ret != -EUCLEAN) {
@@ -98,7 +144,7 @@ static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 			return ret;
 		}
 		if (retlen != length) {
-			printf("Read failure!! retlen=%d\n", retlen);
+			printf("Read failure!! retlen=%zu\n", retlen);
 			return count - remaining + retlen;
 		}
 		mtd_stream->offset += length;
@@ -111,7 +157,10 @@ static uint64_t read_mtd_stream(StreamOps *dev, uint64_t count,
 
 static void close_mtd_stream(StreamOps *me)
 {
-	free(container_of(me, MtdStream, ops));
+	MtdStream *mtd_stream = container_of(me, MtdStream, ops);
+
+	free(mtd_stream->page_buf);
+	free(mtd_stream);
 }
 
 static StreamOps *open_mtd_stream(StreamCtrlr *me, uint64_t offset,
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * A polled virtio block driver. Each read or write is split into requests of
+ * up to seg_max segments, and as many requests as there are descriptors for
+ * are queued before the device is notified once. Notifications are skipped
+ * entirely while the device says it's still processing the queue.
+ */
+
+#include <libpayload.h>
+
+#include "base/container_of.h"
+#include "drivers/storage/virtio_blk.h"
+
+enum {
+	VirtioBlkFSizeMax = 1 << 1,
+	VirtioBlkFSegMax = 1 << 2,
+	VirtioBlkFRo = 1 << 5,
+	VirtioBlkFBlkSize = 1 << 6
+};
+
+enum {
+	VirtioBlkConfigCapacity = 0,
+	VirtioBlkConfigSizeMax = 8,
+	VirtioBlkConfigSegMax = 12,
+	VirtioBlkConfigBlkSize = 20
+};
+
+enum {
+	VirtioBlkTIn = 0,
+	VirtioBlkTOut = 1
+};
+
+enum {
+	VirtioBlkSOk = 0
+};
+
+enum {
+	// Sector numbers are always in 512 byte units.
+	VirtioBlkSectorSize = 512,
+	VirtioBlkQueueSize = 128,
+	VirtioBlkMaxRequests = 32,
+	VirtioBlkMaxSegments = 16,
+	VirtioBlkMaxSegmentBytes = 1024 * 1024,
+	VirtioBlkTimeoutUs = 5 * 1000 * 1000
+};
+
+static int virtio_blk_wait(VirtioBlkCtrlr *blk, int count)
+{
+	uint64_t start = timer_us(0);
+
+	while (count) {
+		if (virtio_queue_get_used(&blk->vq, NULL)) {
+			count--;
+			continue;
+		}
+		if (timer_us(start) > VirtioBlkTimeoutUs)
+			return 1;
+	}
+	return 0;
+}
+
+static lba_t virtio_blk_transfer(VirtioBlkCtrlr *blk, uint32_t type,
+				 lba_t start, lba_t count, uint8_t *buffer)
+{
+	const unsigned block_size = blk->dev.block_size;
+	const uint32_t seg_bytes = blk->size_max;
+	const lba_t req_max_blocks = seg_bytes / block_size * blk->seg_max;
+	lba_t req_blocks[VirtioBlkMaxRequests];
+	lba_t done = 0;
+
+	if (blk->dead) {
+		printf("virtio-blk: Device was reset after a timeout.\n");
+		return 0;
+	}
+
+	while (done < count) {
+		lba_t pos = done;
+		int reqs = 0;
+
+		while (pos < count && reqs < VirtioBlkMaxRequests) {
+			lba_t blocks = MIN(count - pos, req_max_blocks);
+			uint32_t bytes = blocks * block_size;
+			int segs = (bytes + seg_bytes - 1) / seg_bytes;
+
+			if (segs + 2 > blk->vq.num_free)
+				break;
+
+			VirtioBlkReq *req = &blk->reqs[reqs];
+			req->hdr.type = type;
+			req->hdr.reserved = 0;
+			req->hdr.sector = (start + pos) *
+					  (block_size / VirtioBlkSectorSize);
+			req->status = 0xff;
+
+			VirtQueueBuf bufs[VirtioBlkMaxSegments + 2];
+			bufs[0].addr = &req->hdr;
+			bufs[0].len = sizeof(req->hdr);
+			uint8_t *data = buffer + pos * block_size;
+			for (int i = 0; i < segs; i++) {
+				bufs[i + 1].addr = data + i * seg_bytes;
+				bufs[i + 1].len = MIN(seg_bytes,
+						      bytes - i * seg_bytes);
+			}
+			bufs[segs + 1].addr = &req->status;
+			bufs[segs + 1].len = sizeof(req->status);
+
+			int out = type == VirtioBlkTOut ? segs + 1 : 1;
+			if (virtio_queue_add(&blk->vq, bufs, out,
+					     segs + 2 - out, req))
+				break;
+
+			req_blocks[reqs++] = blocks;
+			pos += blocks;
+		}
+
+		if (!reqs) {
+			printf("virtio-blk: Queue too small for a request.\n");
+			return done;
+		}
+
+		virtio_queue_kick(&blk->vq);
+		if (virtio_blk_wait(blk, reqs)) {
+			printf("virtio-blk: Timed out waiting for requests.\n");
+			// The device could still complete them into memory
+			// that's about to be reused, so stop it for good.
+			virtio_reset(blk->virtio);
+			blk->dead = 1;
+			return done;
+		}
+
+		for (int i = 0; i < reqs; i++) {
+			if (blk->reqs[i].status != VirtioBlkSOk) {
+				printf("virtio-blk: Request for block %lld "
+				       "failed with status %d.\n",
+				       (long long)(start + done),
+				       blk->reqs[i].status);
+				return done;
+			}
+			done += req_blocks[i];
+		}
+	}
+
+	return count;
+}
+
+static lba_t virtio_blk_read(BlockDevOps *me, lba_t start, lba_t count,
+			     void *buffer)
+{
+	VirtioBlkCtrlr *blk = container_of(me, VirtioBlkCtrlr, dev.ops);
+
+	return virtio_blk_transfer(blk, VirtioBlkTIn, start, count, buffer);
+}
+
+static lba_t virtio_blk_write(BlockDevOps *me, lba_t start, lba_t count,
+			      const void *buffer)
+{
+	VirtioBlkCtrlr *blk = container_of(me, VirtioBlkCtrlr, dev.ops);
+
+	if (blk->features & VirtioBlkFRo) {
+		printf("virtio-blk: Disk is read only.\n");
+		return 0;
+	}
+
+	return virtio_blk_transfer(blk, VirtioBlkTOut, start, count,
+				   (uint8_t *)buffer);
+}
+
+static int virtio_blk_shutdown(CleanupFunc *cleanup, CleanupType type)
+{
+	VirtioBlkCtrlr *blk = cleanup->data;
+
+	// Stop the device before its queue memory is reused.
+	virtio_reset(blk->virtio);
+	return 0;
+}
+
+static int virtio_blk_ctrlr_init(BlockDevCtrlrOps *me)
+{
+	VirtioBlkCtrlr *blk = container_of(me, VirtioBlkCtrlr, ctrlr.ops);
+	VirtioDevOps *virtio = blk->virtio;
+
+	uint64_t wanted = VirtioBlkFSizeMax | VirtioBlkFSegMax |
+			  VirtioBlkFRo | VirtioBlkFBlkSize;
+	if (virtio_start(virtio, wanted, &blk->features))
+		return 1;
+
+	uint64_t capacity;
+	virtio->read_config(virtio, VirtioBlkConfigCapacity, &capacity,
+			    sizeof(capacity));
+
+	uint32_t block_size = VirtioBlkSectorSize;
+	if (blk->features & VirtioBlkFBlkSize) {
+		virtio->read_config(virtio, VirtioBlkConfigBlkSize,
+				    &block_size, sizeof(block_size));
+		if (block_size < VirtioBlkSectorSize ||
+		    (block_size & (block_size - 1)))
+			block_size = VirtioBlkSectorSize;
+	}
+
+	blk->size_max = VirtioBlkMaxSegmentBytes;
+	if (blk->features & VirtioBlkFSizeMax)
+		virtio->read_config(virtio, VirtioBlkConfigSizeMax,
+				    &blk->size_max, sizeof(blk->size_max));
+	blk->size_max = MIN(blk->size_max, VirtioBlkMaxSegmentBytes);
+	blk->size_max -= blk->size_max % block_size;
+	if (!blk->size_max)
+		blk->size_max = block_size;
+
+	blk->seg_max = VirtioBlkMaxSegments;
+	if (blk->features & VirtioBlkFSegMax)
+		virtio->read_config(virtio, VirtioBlkConfigSegMax,
+				    &blk->seg_max, sizeof(blk->seg_max));
+	blk->seg_max = MAX(1, MIN(blk->seg_max, VirtioBlkMaxSegments));
+
+	if (virtio_queue_init(virtio, &blk->vq, 0, VirtioBlkQueueSize)) {
+		virtio->set_status(virtio, VirtioStatusFailed);
+		return 1;
+	}
+	blk->seg_max = MIN(blk->seg_max, blk->vq.num_free - 2);
+
+	blk->reqs = dma_memalign(sizeof(uint64_t),
+				 sizeof(*blk->reqs) * VirtioBlkMaxRequests);
+
+	virtio_driver_ok(virtio);
+
+	blk->cleanup.cleanup = &virtio_blk_shutdown;
+	blk->cleanup.types = CleanupOnHandoff | CleanupOnLegacy;
+	blk->cleanup.data = blk;
+	list_insert_after(&blk->cleanup.list_node, &cleanup_funcs);
+
+	blk->dev.ops.read = &virtio_blk_read;
+	blk->dev.ops.write = &virtio_blk_write;
+	blk->dev.ops.new_stream = &new_simple_stream;
+	blk->dev.name = "virtio-blk";
+	blk->dev.removable = 0;
+	blk->dev.block_size = block_size;
+	blk->dev.block_count = capacity / (block_size / VirtioBlkSectorSize);
+	list_insert_after(&blk->dev.list_node, &fixed_block_devices);
+
+	printf("Added virtio-blk disk with %lld %d byte blocks.\n",
+	       (long long)blk->dev.block_count, block_size);
+
+	blk->ctrlr.need_update = 0;
+	return 0;
+}
+
+VirtioBlkCtrlr *new_virtio_blk_ctrlr(VirtioDevOps *virtio)
+{
+	VirtioBlkCtrlr *blk = xzalloc(sizeof(*blk));
+
+	blk->ctrlr.ops.update = &virtio_blk_ctrlr_init;
+	blk->ctrlr.need_update = 1;
+	blk->virtio = virtio;
+	return blk;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DRIVERS_STORAGE_VIRTIO_BLK_H__
+#define __DRIVERS_STORAGE_VIRTIO_BLK_H__
+
+#include <stdint.h>
+
+#include "base/cleanup_funcs.h"
+#include "drivers/bus/virtio/virtio.h"
+#include "drivers/storage/blockdev.h"
+
+typedef struct {
+	uint32_t type;
+	uint32_t reserved;
+	uint64_t sector;
+} __attribute__((packed)) VirtioBlkReqHdr;
+
+// The header and status byte of one request, kept in DMA memory.
+typedef struct {
+	VirtioBlkReqHdr hdr;
+	uint8_t status;
+} VirtioBlkReq;
+
+typedef struct {
+	BlockDevCtrlr ctrlr;
+	BlockDev dev;
+
+	VirtioDevOps *virtio;
+	VirtQueue vq;
+	uint64_t features;
+
+	// Largest data segment and number of segments per request.
+	uint32_t size_max;
+	uint32_t seg_max;
+
+	VirtioBlkReq *reqs;
+	// Set once the device has been reset after a request timed out.
+	int dead;
+	CleanupFunc cleanup;
+} VirtioBlkCtrlr;
+
+// A single fixed disk. Add the controller to fixed_block_dev_controllers.
+VirtioBlkCtrlr *new_virtio_blk_ctrlr(VirtioDevOps *virtio);
+
+#endif /* __DRIVERS_STORAGE_VIRTIO_BLK_H__ */
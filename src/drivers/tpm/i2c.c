@@ -99,7 +99,9 @@ static int i2ctpm_xmit(TpmOps *me, const uint8_t *sendbuf, size_t sbuf_size,
 		return -1;
 	}
 
+	// Poll quickly at first and back off to 1ms for long commands.
 	uint64_t start = timer_us(0);
+	unsigned delay = 50;
 	while (1) {
 		assert(tpm->chip_ops.status);
 		uint8_t status = tpm->chip_ops.status(&tpm->chip_ops);
@@ -112,7 +114,8 @@ static int i2ctpm_xmit(TpmOps *me, const uint8_t *sendbuf, size_t sbuf_size,
 			printf("%s: Operation canceled.\n", __func__);
 			return -1;
 		}
-		mdelay(1);
+		udelay(delay);
+		delay = MIN(delay * 2, 1000);
 
 		// Two minute timeout.
 		if (timer_us(start) > 2 * 60 * 1000 * 1000) {
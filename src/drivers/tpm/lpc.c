@@ -70,6 +70,13 @@ enum {
 	TisStsResponseRetry = 0x02
 };
 
+enum {
+	// Data transfer size support, TIS 1.3 only (zero on older TPMs).
+	// 1 is 8 bit only, 2 adds 16 bit and 3 adds 32 bit accesses.
+	TisIntfDataTransferSizeMask = 0x3 << 9,
+	TisIntfDataTransferSize32 = 0x3 << 9,
+};
+
 enum {
 	TisAccessTpmRegValidSts = 0x80,
 	TisAccessActiveLocality = 0x20,
@@ -131,6 +138,21 @@ static const struct vendor_name vendor_names[] = {
  */
 static uint32_t vendor_dev_id;
 
+/*
+ * Most register transitions happen within a few microseconds, but waiting for
+ * a command to execute can take much longer. Poll quickly at first and back
+ * off so a long wait doesn't hog the LPC bus.
+ */
+enum {
+	PollDelayMaxUs = 64
+};
+
+static void poll_delay(unsigned *delay)
+{
+	udelay(*delay);
+	*delay = MIN(*delay * 2, PollDelayMaxUs);
+}
+
 // Retrieve burst count value.
 static uint16_t burst_count(TpmLocality *dev)
 {
@@ -140,6 +162,60 @@ static uint16_t burst_count(TpmLocality *dev)
 	return value;
 }
 
+/*
+ * Wait for at least a second for the TPM to report a nonzero burst count.
+ *
+ * Returns the burst count, or 0 on timeout.
+ */
+static uint16_t wait_burst_count(TpmLocality *dev)
+{
+	uint64_t start = timer_us(0);
+	unsigned delay = 1;
+	uint16_t burst;
+
+	while (!(burst = burst_count(dev))) {
+		if (timer_us(start) > 1000 * 1000)
+			return 0;
+		poll_delay(&delay);
+	}
+	return burst;
+}
+
+/*
+ * Move data through the data FIFO, four bytes at a time if the TPM supports
+ * it and one byte at a time otherwise.
+ */
+static void fifo_write(LpcTpm *tpm, const uint8_t *data, unsigned count)
+{
+	uint8_t *fifo = &tpm->regs->localities[0].data;
+
+	if (tpm->wide_fifo) {
+		for (; count >= sizeof(uint32_t); count -= sizeof(uint32_t)) {
+			uint32_t word;
+			memcpy(&word, data, sizeof(word));
+			writel(word, fifo);
+			data += sizeof(word);
+		}
+	}
+	while (count--)
+		writeb(*data++, fifo);
+}
+
+static void fifo_read(LpcTpm *tpm, uint8_t *data, unsigned count)
+{
+	uint8_t *fifo = &tpm->regs->localities[0].data;
+
+	if (tpm->wide_fifo) {
+		for (; count >= sizeof(uint32_t); count -= sizeof(uint32_t)) {
+			uint32_t word = readl(fifo);
+			memcpy(data, &word, sizeof(word));
+			data += sizeof(word);
+		}
+	}
+	while (count--)
+		*data++ = readb(fifo);
+}
+
 /*
  * lpctpm_wait_reg()
  *
@@ -155,9 +231,11 @@ static uint16_t burst_count(TpmLocality *dev)
 static int lpctpm_wait_reg(uint8_t *reg, uint8_t mask, uint8_t expected)
 {
 	uint64_t start = timer_us(0);
+	unsigned delay = 1;
 	do {
 		if ((readb(reg) & mask) == expected)
 			return 0;
+		poll_delay(&delay);
 	} while (timer_us(start) < 1000 * 1000);
 	return -1;
 }
@@ -223,14 +301,12 @@ static uint32_t lpctpm_senddata(LpcTpm *tpm, const uint8_t * const data,
 
 	while (1) {
 		// Wait till the device is ready to accept more data.
-		uint64_t start = timer_us(0);
-		while (!burst) {
-			if (timer_us(start) > 1000 * 1000) {
-				printf("%s:%d failed to feed %d bytes of %d.\n",
-				       __FILE__, __LINE__, len - offset, len);
-				return -1;
-			}
-			burst = burst_count(&tpm->regs->localities[0]);
+		if (!burst)
+			burst = wait_burst_count(&tpm->regs->localities[0]);
+		if (!burst) {
+			printf("%s:%d failed to feed %d bytes of %d.\n",
+			       __FILE__, __LINE__, len - offset, len);
+			return -1;
 		}
 
 		/*
@@ -243,8 +319,8 @@ static uint32_t lpctpm_senddata(LpcTpm *tpm, const uint8_t * const data,
 		 * FIFO.
 		 */
 		unsigned count = MIN(burst, len - offset - 1);
-		while (count--)
-			writeb(data[offset++], &tpm->regs->localities[0].data);
+		fifo_write(tpm, data + offset, count);
+		offset += count;
 
 		if (lpctpm_wait_reg(&tpm->regs->localities[0].tpm_status,
 				    TisStsValid, TisStsValid) ||
@@ -313,19 +389,25 @@ static uint32_t lpctpm_readresponse(LpcTpm *tpm, uint8_t *buffer, size_t *len)
 	}
 
 	do {
-		uint64_t start = timer_us(0);
-		while ((burst = burst_count(&tpm->regs->localities[0])) == 0) {
-			if (timer_us(start) > 1000 * 1000) {
-				printf("%s:%d TPM stuck on read\n",
-				       __FILE__, __LINE__);
-				return -1;
-			}
-			udelay(1);
+		burst = wait_burst_count(&tpm->regs->localities[0]);
+		if (!burst) {
+			printf("%s:%d TPM stuck on read\n",
+			       __FILE__, __LINE__);
+			return -1;
 		}
 
-		while (burst-- && (offset < expected_count)) {
-			buffer[offset++] =
-				readb(&tpm->regs->localities[0].data);
+		while (burst && (offset < expected_count)) {
+			/*
+			 * Stop after the first six bytes of the reply so we
+			 * can figure out how many bytes to expect in total.
+			 */
+			unsigned count = MIN(burst, expected_count - offset);
+			if (offset < 6)
+				count = MIN(count, 6 - offset);
+
+			fifo_read(tpm, buffer + offset, count);
+			offset += count;
+			burst -= count;
 
 			if (offset == 6) {
 				/*
@@ -451,6 +533,10 @@ int lpctpm_init(LpcTpm *tpm)
 
 	printf("Found TPM %s by %s\n", device_name, vendor_name);
 
+	tpm->wide_fifo = (readl(&tpm->regs->localities[0].int_capability) &
+			  TisIntfDataTransferSizeMask) ==
+			 TisIntfDataTransferSize32;
+
 	if (lpctpm_close(tpm))
 		return -1;
 
@@ -33,6 +33,8 @@ typedef struct {
 	TpmOps ops;
 
 	int initialized;
+	// Whether the data FIFO can be accessed 32 bits at a time.
+	int wide_fifo;
 	TpmRegs *regs;
 	CleanupFunc cleanup;
 } LpcTpm;
@@ -45,9 +45,20 @@
 #include "drivers/tpm/slb9635_i2c.h"
 
 enum {
-	TpmTimeout = 1 // msecs
+	TpmTimeout = 1, // msecs
+	TpmPollMinDelay = 50 // usecs
 };
 
+/*
+ * The TPM usually responds within a fraction of TpmTimeout, so start polling
+ * quickly and back off to TpmTimeout between polls for longer waits.
+ */
+static void poll_delay(unsigned *delay)
+{
+	udelay(*delay);
+	*delay = MIN(*delay * 2, TpmTimeout * 1000);
+}
+
 // Expected value for DIDVID register.
 enum {
 	TPM_TIS_I2C_DID_VID_9635 = 0x000b15d1L,
@@ -267,10 +278,11 @@ static int request_locality(Slb9635I2c *tpm, int loc)
 
 	// Wait for burstcount.
 	uint64_t start = timer_us(0);
+	unsigned delay = TpmPollMinDelay;
 	while (timer_us(start) < 2 * 1000 * 1000) { // Two second timeout.
 		if (check_locality(tpm, loc) >= 0)
 			return loc;
-		mdelay(TpmTimeout);
+		poll_delay(&delay);
 	}
 
 	return -1;
@@ -302,6 +314,7 @@ static ssize_t get_burstcount(Slb9635I2c *tpm)
 
 	// Wait for burstcount.
 	uint64_t start = timer_us(0);
+	unsigned delay = TpmPollMinDelay;
 	while (timer_us(start) < 2 * 1000 * 1000) { // Two second timeout.
 		// Note: STS is little endian.
 		if (iic_tpm_read(tpm, tpm_sts(tpm->base.locality) + 1,
@@ -312,7 +325,7 @@ static ssize_t get_burstcount(Slb9635I2c *tpm)
 
 		if (burstcnt)
 			return burstcnt;
-		mdelay(TpmTimeout);
+		poll_delay(&delay);
 	}
 	return -1;
 }
@@ -320,12 +333,13 @@ static ssize_t get_burstcount(Slb9635I2c *tpm)
 static int wait_for_stat(Slb9635I2c *tpm, uint8_t mask, int *status)
 {
 	uint64_t start = timer_us(0);
+	unsigned delay = TpmPollMinDelay;
 	while (timer_us(start) < 2 * 1000 * 1000) { // Two second timeout.
 		// Check current status.
 		*status = tpm_status(&tpm->base.chip_ops);
 		if ((*status & mask) == mask)
 			return 0;
-		mdelay(TpmTimeout);
+		poll_delay(&delay);
 	}
 
 	return -1;
@@ -20,21 +20,124 @@
  * MA 02111-1307 USA
  */
 
+#include <endian.h>
 #include <libpayload.h>
 
+#include "base/boot_perf.h"
+#include "base/cleanup_funcs.h"
+#include "config.h"
 #include "drivers/tpm/tpm.h"
 
 static TpmOps *tpm_ops;
 
+static TpmOrdinalStats tpm_stats[TpmMaxStatsOrdinals];
+static int tpm_stats_count;
+
 void tpm_set_ops(TpmOps *ops)
 {
 	die_if(tpm_ops, "%s: TPM ops already set.\n", __func__);
 	tpm_ops = ops;
 }
 
+static TpmOrdinalStats *tpm_find_stats(uint32_t ordinal)
+{
+	for (int i = 0; i < tpm_stats_count; i++)
+		if (tpm_stats[i].ordinal == ordinal)
+			return &tpm_stats[i];
+
+	if (tpm_stats_count == ARRAY_SIZE(tpm_stats))
+		return NULL;
+
+	TpmOrdinalStats *stats = &tpm_stats[tpm_stats_count++];
+	memset(stats, 0, sizeof(*stats));
+	stats->ordinal = ordinal;
+	stats->min_us = ~0U;
+	return stats;
+}
+
+static void tpm_record_stats(const uint8_t *sendbuf, size_t send_size,
+			     size_t recv_len, uint32_t us, int failed)
+{
+	uint32_t ordinal;
+
+	if (send_size < TpmCmdOrdinalOffset + sizeof(ordinal))
+		return;
+	memcpy(&ordinal, sendbuf + TpmCmdOrdinalOffset, sizeof(ordinal));
+
+	TpmOrdinalStats *stats = tpm_find_stats(betohl(ordinal));
+	if (!stats)
+		return;
+
+	stats->count++;
+	if (failed)
+		stats->errors++;
+	stats->bytes_sent += send_size;
+	stats->bytes_received += recv_len;
+	stats->total_us += us;
+	stats->min_us = MIN(stats->min_us, us);
+	stats->max_us = MAX(stats->max_us, us);
+}
+
+static int tpm_stats_cleanup(CleanupFunc *cleanup, CleanupType type)
+{
+	tpm_print_stats();
+	return 0;
+}
+
 int tpm_xmit(const uint8_t *sendbuf, size_t send_size,
 	     uint8_t *recvbuf, size_t *recv_len)
 {
+	static CleanupFunc cleanup = {
+		&tpm_stats_cleanup,
+		CleanupOnReboot | CleanupOnPowerOff |
+		CleanupOnHandoff | CleanupOnLegacy,
+		NULL
+	};
+	static int cleanup_installed;
+
 	die_if(!tpm_ops, "%s: No TPM ops set.\n", __func__);
-	return tpm_ops->xmit(tpm_ops, sendbuf, send_size, recvbuf, recv_len);
+
+	if (CONFIG_DRIVER_TPM_STATS && !cleanup_installed) {
+		list_insert_after(&cleanup.list_node, &cleanup_funcs);
+		cleanup_installed = 1;
+	}
+
+	uint64_t start = timer_us(0);
+	int res = tpm_ops->xmit(tpm_ops, sendbuf, send_size,
+				recvbuf, recv_len);
+	uint64_t us = timer_us(start);
+	tpm_record_stats(sendbuf, send_size, res ? 0 : *recv_len, us, res);
+	boot_perf_add(BootPerfTpmCommands, 1);
+	boot_perf_add(BootPerfTpmErrors, !!res);
+	boot_perf_add(BootPerfTpmUs, us);
+
+	return res;
+}
+
+int tpm_get_stats(const TpmOrdinalStats **stats)
+{
+	*stats = tpm_stats;
+	return tpm_stats_count;
+}
+
+void tpm_print_stats(void)
+{
+	uint32_t count = 0;
+	uint64_t total_us = 0;
+
+	printf("TPM command statistics:\n");
+	printf("  ordinal  count  errs   sent   recv"
+	       "     min     avg     max   total (us)\n");
+	for (int i = 0; i < tpm_stats_count; i++) {
+		TpmOrdinalStats *stats = &tpm_stats[i];
+
+		printf("  %#8x %5u %5u %6llu %6llu %7u %7llu %7u %7llu\n",
+		       stats->ordinal, stats->count, stats->errors,
+		       stats->bytes_sent, stats->bytes_received,
+		       stats->min_us, stats->total_us / stats->count,
+		       stats->max_us, stats->total_us);
+		count += stats->count;
+		total_us += stats->total_us;
+	}
+	printf("  %u commands, %llu us total\n", count, total_us);
 }
@@ -55,4 +55,35 @@ void tpm_set_ops(TpmOps *ops);
 int tpm_xmit(const uint8_t *sendbuf, size_t send_size,
 	     uint8_t *recvbuf, size_t *recv_len);
 
+/*
+ * Timing statistics for all commands sent through tpm_xmit() with a given
+ * ordinal. Failed commands count towards the time but not the bytes
+ * received.
+ */
+typedef struct TpmOrdinalStats
+{
+	uint32_t ordinal;
+	uint32_t count;
+	uint32_t errors;
+	uint64_t bytes_sent;
+	uint64_t bytes_received;
+	uint64_t total_us;
+	uint32_t min_us;
+	uint32_t max_us;
+} TpmOrdinalStats;
+
+enum {
+	// Commands with more distinct ordinals than this aren't tracked.
+	TpmMaxStatsOrdinals = 32
+};
+
+/*
+ * Retrieve the per-ordinal statistics collected so far. Returns the number of
+ * entries and points stats at them.
+ */
+int tpm_get_stats(const TpmOrdinalStats **stats);
+
+// Print the per-ordinal statistics collected so far to the console.
+void tpm_print_stats(void);
+
 #endif /* __DRIVERS_TPM_TPM_H__ */
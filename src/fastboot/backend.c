@@ -24,6 +24,7 @@
 
 #include "base/gpt.h"
 #include "fastboot/backend.h"
+#include "fastboot/sparse.h"
 
 #define BACKEND_DEBUG
 
@@ -58,224 +59,6 @@ backend_ret_t __attribute__((weak)) board_write_partition(const char *name,
 }
 
 
-/********************** Sparse Image Handling ****************************/
-
-/* Sparse Image Header */
-struct sparse_image_hdr {
-	/* Magic number for sparse image 0xed26ff3a. */
-	uint32_t magic;
-	/* Major version = 0x1 */
-	uint16_t major_version;
-	uint16_t minor_version;
-	uint16_t file_hdr_size;
-	uint16_t chunk_hdr_size;
-	/* Size of block in bytes. */
-	uint32_t blk_size;
-	/* # of blocks in the non-sparse image. */
-	uint32_t total_blks;
-	/* # of chunks in the sparse image. */
-	uint32_t total_chunks;
-	uint32_t image_checksum;
-};
-
-#define SPARSE_IMAGE_MAGIC	0xed26ff3a
-#define CHUNK_TYPE_RAW		0xCAC1
-#define CHUNK_TYPE_FILL	0xCAC2
-#define CHUNK_TYPE_DONT_CARE	0xCAC3
-#define CHUNK_TYPE_CRC32	0xCAC4
-
-/* Chunk header in sparse image */
-struct sparse_chunk_hdr {
-	uint16_t type;
-	uint16_t reserved;
-	/* Chunk size is in number of blocks */
-	uint32_t size_in_blks;
-	/* Size in bytes of chunk header and data */
-	uint32_t total_size_bytes;
-};
-
-/* Check if given image is sparse */
-int is_sparse_image(void *image_addr)
-{
-	struct sparse_image_hdr *hdr = image_addr;
-
-	/* AOSP sparse format supports major version 0x1 only */
-	return ((hdr->magic == SPARSE_IMAGE_MAGIC) &&
-		(hdr->major_version == 0x1));
-}
-
-/* Write sparse image to partition */
-static backend_ret_t write_sparse_image(struct image_part_details *img,
-					void *image_addr, uint64_t image_size)
-{
-	struct sparse_image_hdr *img_hdr = image_addr;
-	struct sparse_chunk_hdr *chunk_hdr;
-	uint64_t bdev_block_size = img->bdev_entry->bdev->block_size;
-
-	BE_LOG("Magic          : %x\n", img_hdr->magic);
-	BE_LOG("Major Version  : %x\n", img_hdr->major_version);
-	BE_LOG("Minor Version  : %x\n", img_hdr->minor_version);
-	BE_LOG("File Hdr Size  : %x\n", img_hdr->file_hdr_size);
-	BE_LOG("Chunk Hdr Size : %x\n", img_hdr->chunk_hdr_size);
-	BE_LOG("Blk Size       : %x\n", img_hdr->blk_size);
-	BE_LOG("Total blks     : %x\n", img_hdr->total_blks);
-	BE_LOG("Total chunks   : %x\n", img_hdr->total_chunks);
-	BE_LOG("Checksum       : %x\n", img_hdr->image_checksum);
-
-	/* Is image header size as expected? */
-	if (img_hdr->file_hdr_size != sizeof(*img_hdr))
-		return BE_SPARSE_HDR_ERR;
-
-	/* Is image block size multiple of bdev block size? */
-	if (img_hdr->blk_size != ALIGN_DOWN(img_hdr->blk_size, bdev_block_size))
-		return BE_IMAGE_SIZE_MULTIPLE_ERR;
-
-	/* Is chunk header size as expected? */
-	if (img_hdr->chunk_hdr_size != sizeof(*chunk_hdr))
-		return BE_CHUNK_HDR_ERR;
-
-	int i;
-	uint64_t part_addr = img->part_addr;
-	uint64_t part_size_lba = img->part_size_lba;
-	BlockDevOps *ops = &img->bdev_entry->bdev->ops;
-	/* data_ptr points to first byte after image header */
-	uint8_t *data_ptr = image_addr;
-	data_ptr += sizeof(*img_hdr);
-
-	/* Perform the following operation on each chunk */
-	for (i = 0; i < img_hdr->total_chunks; i++) {
-		/* Get chunk header */
-		chunk_hdr = (struct sparse_chunk_hdr *)data_ptr;
-
-		BE_LOG("Chunk %d\n", i);
-		BE_LOG("Type         : %x\n", chunk_hdr->type);
-		BE_LOG("Size in blks : %x\n", chunk_hdr->size_in_blks);
-		BE_LOG("Total size   : %x\n", chunk_hdr->total_size_bytes);
-		BE_LOG("Part addr    : %llx\n", part_addr);
-
-		/*
-		 * Make data_ptr point to chunk data(if any):
-		 * Raw chunk data = chunk_size_in_blks * img_blk_size
-		 * Fill chunk data = 4 bytes of fill data
-		 * CRC32 chunk data = 4 bytes of CRC32
-		 */
-		data_ptr += sizeof(*chunk_hdr);
-
-		/* Size in bytes and lba of the area occupied by chunk range */
-		uint64_t chunk_size_bytes, chunk_size_lba;
-
-		chunk_size_bytes = (uint64_t)chunk_hdr->size_in_blks *
-			img_hdr->blk_size;
-		chunk_size_lba = chunk_size_bytes / bdev_block_size;
-
-		/* Should not write past partition size */
-		if (part_size_lba < chunk_size_lba) {
-			BE_LOG("part_size_lba:%llx\n", part_size_lba);
-			BE_LOG("chunk_size_lba:%llx\n", chunk_size_lba);
-			return BE_IMAGE_OVERFLOW_ERR;
-		}
-
-		switch (chunk_hdr->type) {
-		case CHUNK_TYPE_RAW: {
-
-			/*
-			 * For Raw chunk type:
-			 * chunk_size_bytes + chunk_hdr_size = chunk_total_size
-			 */
-			if ((chunk_size_bytes + sizeof(*chunk_hdr))!=
-			    chunk_hdr->total_size_bytes) {
-				BE_LOG("chunk_size_bytes:%llx\n",
-				       chunk_size_bytes + sizeof(*chunk_hdr));
-				BE_LOG("total_size_bytes:%x\n",
-				       chunk_hdr->total_size_bytes);
-				return BE_CHUNK_HDR_ERR;
-			}
-
-			if (ops->write(ops, part_addr, chunk_size_lba, data_ptr)
-			    != chunk_size_lba)
-				return BE_WRITE_ERR;
-
-			/*
-			 * Data present in chunk sparse image is
-			 * chunk_size_bytes
-			 */
-			data_ptr += chunk_size_bytes;
-
-			break;
-		}
-		case CHUNK_TYPE_FILL: {
-			/*
-			 * For fill chunk type:
-			 * chunk_hdr_size + 4 bytes = chunk_total_size_bytes
-			 */
-			if (sizeof(uint32_t) + sizeof(*chunk_hdr) !=
-			    chunk_hdr->total_size_bytes) {
-				BE_LOG("chunk_size_bytes:%zx\n",
-				       sizeof(uint32_t) + sizeof(*chunk_hdr));
-				BE_LOG("total_size_bytes:%x\n",
-				       chunk_hdr->total_size_bytes);
-				return BE_CHUNK_HDR_ERR;
-			}
-
-			/* Perform fill_write operation */
-			if (ops->fill_write(ops, part_addr, chunk_size_lba,
-					    *(uint32_t *)data_ptr)
-			    != chunk_size_lba)
-				return BE_WRITE_ERR;
-
-			/* Data present in chunk sparse image is 4 bytes */
-			data_ptr += sizeof(uint32_t);
-
-			break;
-		}
-		case CHUNK_TYPE_DONT_CARE: {
-			/*
-			 * For dont care chunk type:
-			 * chunk_hdr_size = chunk_total_size_bytes
-			 * data in sparse image = 0 bytes
-			 */
-			if (sizeof(*chunk_hdr) != chunk_hdr->total_size_bytes) {
-				BE_LOG("chunk_size_bytes:%zx\n",
-				       sizeof(*chunk_hdr));
-				BE_LOG("total_size_bytes:%x\n",
-				       chunk_hdr->total_size_bytes);
-				return BE_CHUNK_HDR_ERR;
-			}
-			break;
-		}
-		case CHUNK_TYPE_CRC32: {
-			/*
-			 * For crc32 chunk type:
-			 * chunk_hdr_size + 4 bytes = chunk_total_size_bytes
-			 */
-			if (sizeof(uint32_t) + sizeof(*chunk_hdr) !=
-			    chunk_hdr->total_size_bytes) {
-				BE_LOG("chunk_size_bytes:%zx\n",
-				       sizeof(uint32_t) + sizeof(*chunk_hdr));
-				BE_LOG("total_size_bytes:%x\n",
-				       chunk_hdr->total_size_bytes);
-				return BE_CHUNK_HDR_ERR;
-			}
-
-			/* TODO(furquan): Verify CRC32 header? */
-
-			/* Data present in chunk sparse image = 4 bytes */
-			data_ptr += sizeof(uint32_t);
-		}
-		default: {
-			/* Unknown chunk type */
-			BE_LOG("Unknown chunk type %d\n", chunk_hdr->type);
-			return BE_CHUNK_HDR_ERR;
-		}
-		}
-		/* Update partition address and size accordingly */
-		part_addr += chunk_size_lba;
-		part_size_lba -= chunk_size_lba;
-	}
-
-	return BE_SUCCESS;
-}
-
 /********************** Raw Image Handling *******************************/
 
 static backend_ret_t write_raw_image(struct image_part_details *img,
@@ -482,7 +265,10 @@ backend_ret_t backend_write_partition(const char *name, void *image_addr,
 
 	if (is_sparse_image(image_addr)) {
 		BE_LOG("Writing sparse image to %s...\n", name);
-		ret = write_sparse_image(&img, image_addr, image_size);
+		ret = write_sparse_image(&img.bdev_entry->bdev->ops,
+					 img.bdev_entry->bdev->block_size,
+					 img.part_addr, img.part_size_lba,
+					 image_addr, image_size);
 	} else {
 		BE_LOG("Writing raw image to %s...\n", name);
 		ret = write_raw_image(&img, image_addr, image_size);
@@ -90,7 +90,6 @@ uint64_t backend_get_part_size_bytes(const char *name);
 const char *backend_get_part_fs_type(const char *name);
 uint64_t backend_get_bdev_size_bytes(const char *name);
 uint64_t backend_get_bdev_size_blocks(const char *name);
-int is_sparse_image(void *image_addr);
 struct part_info *get_part_info(const char *name);
 
 static inline int fb_fill_bdev_list(int index, BlockDevCtrlr *bdev_ctrlr)
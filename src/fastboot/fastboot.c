@@ -1027,6 +1027,13 @@ static fb_ret_type fb_boot(struct fb_cmd *cmd)
 
 	kernel_size = image_size - kernel_size;
 
+	// Memory boot images are checked against the GBB's recovery key.
+	if (gbb_copy_in_recovery_key()) {
+		fb_add_string(&cmd->output, "couldn't read recovery key",
+			      NULL);
+		return FB_SUCCESS;
+	}
+
 	if (VbVerifyMemoryBootImage(&cparams, &kparams, kernel, kernel_size) !=
 	    VBERROR_SUCCESS) {
 		/*
@@ -1301,6 +1308,12 @@ static fb_ret_type fb_set_off_mode_charge(struct fb_cmd *cmd)
 	}
 
 	vbnv_write(VBNV_BOOT_ON_AC_DETECT, boot_on_ac);
+	// Fastboot can end with a power button press or a battery pull.
+	if (vbnv_flush()) {
+		fb_add_string(&cmd->output, "Failed to save off-mode-charge",
+			      NULL);
+		return FB_SUCCESS;
+	}
 
 	cmd->type = FB_OKAY;
 	return FB_SUCCESS;
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "fastboot/sparse.h"
+
+/*
+ * Tracing every chunk over the console costs more than writing most of them,
+ * so it's only done when debugging the parser.
+ */
+#ifdef SPARSE_DEBUG
+#define SPARSE_LOG(args...)	printf(args)
+#else
+#define SPARSE_LOG(args...)
+#endif
+
+/* Sparse Image Header */
+struct sparse_image_hdr {
+	/* Magic number for sparse image 0xed26ff3a. */
+	uint32_t magic;
+	/* Major version = 0x1 */
+	uint16_t major_version;
+	uint16_t minor_version;
+	uint16_t file_hdr_size;
+	uint16_t chunk_hdr_size;
+	/* Size of block in bytes. */
+	uint32_t blk_size;
+	/* # of blocks in the non-sparse image. */
+	uint32_t total_blks;
+	/* # of chunks in the sparse image. */
+	uint32_t total_chunks;
+	uint32_t image_checksum;
+};
+
+#define SPARSE_IMAGE_MAGIC	0xed26ff3a
+#define CHUNK_TYPE_RAW		0xCAC1
+#define CHUNK_TYPE_FILL	0xCAC2
+#define CHUNK_TYPE_DONT_CARE	0xCAC3
+#define CHUNK_TYPE_CRC32	0xCAC4
+
+/* Chunk header in sparse image */
+struct sparse_chunk_hdr {
+	uint16_t type;
+	uint16_t reserved;
+	/* Chunk size is in number of blocks */
+	uint32_t size_in_blks;
+	/* Size in bytes of chunk header and data */
+	uint32_t total_size_bytes;
+};
+
+/* Largest buffer used to write out fill patterns fill_write can't handle. */
+#define SPARSE_FILL_BUF_SIZE	(64 * KiB)
+
+/* Check if given image is sparse */
+int is_sparse_image(void *image_addr)
+{
+	struct sparse_image_hdr *hdr = image_addr;
+
+	/* AOSP sparse format supports major version 0x1 only */
+	return ((hdr->magic == SPARSE_IMAGE_MAGIC) &&
+		(hdr->major_version == 0x1));
+}
+
+/* Fill count blocks at start with the 32 bit pattern fill. */
+static backend_ret_t sparse_fill(BlockDevOps *ops, unsigned block_size,
+				 lba_t start, lba_t count, uint32_t fill)
+{
+	const uint8_t *bytes = (const uint8_t *)&fill;
+
+	/* fill_write only repeats a single byte, which is the usual case. */
+	if (bytes[0] == bytes[1] && bytes[0] == bytes[2] &&
+	    bytes[0] == bytes[3]) {
+		if (ops->fill_write(ops, start, count, bytes[0]) != count)
+			return BE_WRITE_ERR;
+		return BE_SUCCESS;
+	}
+
+	lba_t buf_blocks = MAX(SPARSE_FILL_BUF_SIZE / block_size, 1);
+	buf_blocks = MIN(buf_blocks, count);
+	size_t buf_words = buf_blocks * block_size / sizeof(fill);
+	uint32_t *buf = xmalloc(buf_words * sizeof(fill));
+	for (size_t i = 0; i < buf_words; i++)
+		buf[i] = fill;
+
+	backend_ret_t ret = BE_SUCCESS;
+	while (count) {
+		lba_t todo = MIN(count, buf_blocks);
+		if (ops->write(ops, start, todo, buf) != todo) {
+			ret = BE_WRITE_ERR;
+			break;
+		}
+		start += todo;
+		count -= todo;
+	}
+
+	free(buf);
+	return ret;
+}
+
+backend_ret_t write_sparse_image(BlockDevOps *ops, unsigned block_size,
+				 uint64_t part_addr, uint64_t part_size_lba,
+				 void *image_addr, uint64_t image_size)
+{
+	struct sparse_image_hdr *img_hdr = image_addr;
+	struct sparse_chunk_hdr *chunk_hdr;
+	uint8_t *image_end = (uint8_t *)image_addr + image_size;
+
+	if (image_size < sizeof(*img_hdr))
+		return BE_SPARSE_HDR_ERR;
+
+	SPARSE_LOG("Magic          : %x\n", img_hdr->magic);
+	SPARSE_LOG("Major Version  : %x\n", img_hdr->major_version);
+	SPARSE_LOG("Minor Version  : %x\n", img_hdr->minor_version);
+	SPARSE_LOG("File Hdr Size  : %x\n", img_hdr->file_hdr_size);
+	SPARSE_LOG("Chunk Hdr Size : %x\n", img_hdr->chunk_hdr_size);
+	SPARSE_LOG("Blk Size       : %x\n", img_hdr->blk_size);
+	SPARSE_LOG("Total blks     : %x\n", img_hdr->total_blks);
+	SPARSE_LOG("Total chunks   : %x\n", img_hdr->total_chunks);
+	SPARSE_LOG("Checksum       : %x\n", img_hdr->image_checksum);
+
+	/* Is image header size as expected? */
+	if (img_hdr->file_hdr_size != sizeof(*img_hdr))
+		return BE_SPARSE_HDR_ERR;
+
+	/* Is image block size multiple of bdev block size? */
+	if (!img_hdr->blk_size ||
+	    img_hdr->blk_size != ALIGN_DOWN(img_hdr->blk_size, block_size))
+		return BE_IMAGE_SIZE_MULTIPLE_ERR;
+
+	/* Is chunk header size as expected? */
+	if (img_hdr->chunk_hdr_size != sizeof(*chunk_hdr))
+		return BE_CHUNK_HDR_ERR;
+
+	int i;
+	/* data_ptr points to first byte after image header */
+	uint8_t *data_ptr = image_addr;
+	data_ptr += sizeof(*img_hdr);
+
+	/* Perform the following operation on each chunk */
+	for (i = 0; i < img_hdr->total_chunks; i++) {
+		if (image_end - data_ptr < sizeof(*chunk_hdr)) {
+			printf("Sparse image truncated at chunk %d.\n", i);
+			return BE_CHUNK_HDR_ERR;
+		}
+
+		/* Get chunk header */
+		chunk_hdr = (struct sparse_chunk_hdr *)data_ptr;
+
+		SPARSE_LOG("Chunk %d\n", i);
+		SPARSE_LOG("Type         : %x\n", chunk_hdr->type);
+		SPARSE_LOG("Size in blks : %x\n", chunk_hdr->size_in_blks);
+		SPARSE_LOG("Total size   : %x\n", chunk_hdr->total_size_bytes);
+		SPARSE_LOG("Part addr    : %llx\n", part_addr);
+
+		/*
+		 * Make data_ptr point to chunk data(if any):
+		 * Raw chunk data = chunk_size_in_blks * img_blk_size
+		 * Fill chunk data = 4 bytes of fill data
+		 * CRC32 chunk data = 4 bytes of CRC32
+		 */
+		data_ptr += sizeof(*chunk_hdr);
+
+		/* Size in bytes and lba of the area occupied by chunk range */
+		uint64_t chunk_size_bytes, chunk_size_lba;
+
+		chunk_size_bytes = (uint64_t)chunk_hdr->size_in_blks *
+			img_hdr->blk_size;
+		chunk_size_lba = chunk_size_bytes / block_size;
+
+		/* Should not write past partition size */
+		if (part_size_lba < chunk_size_lba) {
+			printf("Sparse chunk %d of %llx blocks overflows "
+			       "partition with %llx left.\n", i,
+			       chunk_size_lba, part_size_lba);
+			return BE_IMAGE_OVERFLOW_ERR;
+		}
+
+		/* Data in the image after the chunk header. */
+		uint64_t data_size = chunk_hdr->total_size_bytes -
+			(uint64_t)sizeof(*chunk_hdr);
+		if (chunk_hdr->total_size_bytes < sizeof(*chunk_hdr) ||
+		    image_end - data_ptr < data_size) {
+			printf("Sparse chunk %d has bad size %x.\n", i,
+			       chunk_hdr->total_size_bytes);
+			return BE_CHUNK_HDR_ERR;
+		}
+
+		switch (chunk_hdr->type) {
+		case CHUNK_TYPE_RAW: {
+
+			/*
+			 * For Raw chunk type:
+			 * chunk_size_bytes + chunk_hdr_size = chunk_total_size
+			 */
+			if (data_size != chunk_size_bytes) {
+				printf("Raw chunk %d should have %llx bytes, "
+				       "has %llx.\n", i, chunk_size_bytes,
+				       data_size);
+				return BE_CHUNK_HDR_ERR;
+			}
+
+			if (ops->write(ops, part_addr, chunk_size_lba, data_ptr)
+			    != chunk_size_lba)
+				return BE_WRITE_ERR;
+
+			break;
+		}
+		case CHUNK_TYPE_FILL: {
+			/*
+			 * For fill chunk type:
+			 * chunk_hdr_size + 4 bytes = chunk_total_size_bytes
+			 */
+			if (data_size != sizeof(uint32_t)) {
+				printf("Fill chunk %d has %llx bytes of "
+				       "data.\n", i, data_size);
+				return BE_CHUNK_HDR_ERR;
+			}
+
+			backend_ret_t ret = sparse_fill(ops, block_size,
+						part_addr, chunk_size_lba,
+						*(uint32_t *)data_ptr);
+			if (ret != BE_SUCCESS)
+				return ret;
+
+			break;
+		}
+		case CHUNK_TYPE_DONT_CARE: {
+			/*
+			 * For dont care chunk type:
+			 * chunk_hdr_size = chunk_total_size_bytes
+			 * data in sparse image = 0 bytes
+			 */
+			if (data_size) {
+				printf("Don't care chunk %d has %llx bytes "
+				       "of data.\n", i, data_size);
+				return BE_CHUNK_HDR_ERR;
+			}
+			break;
+		}
+		case CHUNK_TYPE_CRC32: {
+			/*
+			 * For crc32 chunk type:
+			 * chunk_hdr_size + 4 bytes = chunk_total_size_bytes
+			 */
+			if (data_size != sizeof(uint32_t)) {
+				printf("CRC32 chunk %d has %llx bytes of "
+				       "data.\n", i, data_size);
+				return BE_CHUNK_HDR_ERR;
+			}
+
+			/* TODO(furquan): Verify CRC32 header? */
+			break;
+		}
+		default: {
+			/* Unknown chunk type */
+			printf("Unknown chunk type %x\n", chunk_hdr->type);
+			return BE_CHUNK_HDR_ERR;
+		}
+		}
+
+		data_ptr += data_size;
+
+		/* Update partition address and size accordingly */
+		part_addr += chunk_size_lba;
+		part_size_lba -= chunk_size_lba;
+	}
+
+	return BE_SUCCESS;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __FASTBOOT_SPARSE_H__
+#define __FASTBOOT_SPARSE_H__
+
+#include <stdint.h>
+
+#include "drivers/storage/blockdev.h"
+#include "fastboot/backend.h"
+
+/* Check if given image is in the AOSP sparse format. */
+int is_sparse_image(void *image_addr);
+
+/*
+ * Expand the sparse image at image_addr into the part_size_lba blocks of ops
+ * starting at part_addr. Nothing is read from past image_addr + image_size.
+ */
+backend_ret_t write_sparse_image(BlockDevOps *ops, unsigned block_size,
+				 uint64_t part_addr, uint64_t part_size_lba,
+				 void *image_addr, uint64_t image_size);
+
+#endif /* __FASTBOOT_SPARSE_H__ */
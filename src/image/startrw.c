@@ -24,6 +24,7 @@
 #include <lzma.h>
 
 #include "base/elf.h"
+#include "base/timestamp.h"
 #include "image/enter_trampoline.h"
 #include "image/startrw.h"
 #include "image/symbols.h"
@@ -34,12 +35,14 @@ int start_rw_firmware(const void *compressed_image, uint32_t size)
 	void *elf_image = &_tramp_end;
 
 	// Decompress the RW image.
+	timestamp_add_now(TS_RO_RW_DECOMPRESS);
 	uint32_t out_size = ulzman(compressed_image, size, elf_image,
 				   &_kernel_end - &_tramp_end);
 	if (!out_size) {
 		printf("Error decompressing RW firmware.\n");
 		return -1;
 	}
+	timestamp_add_now(TS_RO_RW_DECOMPRESS_DONE);
 
 	// Check that it's a reasonable ELF image.
 	unsigned char *e_ident = elf_image;
@@ -60,6 +60,7 @@ static void enable_graphics(void)
 		printf("Enabling graphics.\n");
 
 		vbnv_write(VBNV_OPROM_NEEDED, 1);
+		vbnv_flush();
 
 		printf("Rebooting.\n");
 		if (cold_reboot())
@@ -212,7 +213,7 @@ int netboot_entry(void)
 
 	timestamp_init();
 
-	if (run_init_funcs())
+	if (run_init_funcs() || run_deferred_init_funcs())
 		halt();
 
 	// Make sure graphics are available if they aren't already.
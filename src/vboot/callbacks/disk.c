@@ -24,9 +24,15 @@
 #include <libpayload.h>
 #include <vboot_api.h>
 
+#include "base/boot_perf.h"
+#include "base/timestamp.h"
 #include "drivers/storage/blockdev.h"
 #include "drivers/storage/stream.h"
 
+// When the open kernel stream was opened, for its share of the boot_perf
+// stream time. vboot only has one stream open at a time.
+static uint64_t stream_open_us;
+
 static void setup_vb_disk_info(VbDiskInfo *disk, BlockDev *bdev)
 {
 	disk->name = bdev->name;
@@ -80,11 +86,15 @@ VbError_t VbExDiskFreeInfo(VbDiskInfo *infos,
 VbError_t VbExDiskRead(VbExDiskHandle_t handle, uint64_t lba_start,
 		       uint64_t lba_count, void *buffer)
 {
-	BlockDevOps *ops = &((BlockDev *)handle)->ops;
+	BlockDev *bdev = (BlockDev *)handle;
+	BlockDevOps *ops = &bdev->ops;
+	uint64_t start = timer_us(0);
 	if (ops->read(ops, lba_start, lba_count, buffer) != lba_count) {
 		printf("Read failed.\n");
 		return VBERROR_UNKNOWN;
 	}
+	boot_perf_add(BootPerfDiskReadUs, timer_us(start));
+	boot_perf_add(BootPerfDiskReadBytes, lba_count * bdev->block_size);
 	return VBERROR_SUCCESS;
 }
 
@@ -102,23 +112,30 @@ VbError_t VbExDiskWrite(VbExDiskHandle_t handle, uint64_t lba_start,
 VbError_t VbExStreamOpen(VbExDiskHandle_t handle, uint64_t lba_start,
 			 uint64_t lba_count, VbExStream_t *stream_ptr)
 {
-	BlockDevOps *ops = &((BlockDev *)handle)->ops;
+	BlockDev *bdev = (BlockDev *)handle;
+	BlockDevOps *ops = &bdev->ops;
+	timestamp_add_now(TS_KERNEL_READ);
+	boot_perf_set_device(bdev->name);
 	*stream_ptr = (VbExStream_t)ops->new_stream(ops, lba_start, lba_count);
 	if (*stream_ptr == NULL) {
 		printf("Stream open failed.\n");
 		return VBERROR_UNKNOWN;
 	}
+	stream_open_us = timer_us(0);
 	return VBERROR_SUCCESS;
 }
 
 VbError_t VbExStreamRead(VbExStream_t stream, uint32_t bytes, void *buffer)
 {
 	StreamOps *dev = (StreamOps *)stream;
+	uint64_t start = timer_us(0);
 	int ret = dev->read(dev, bytes, buffer);
 	if (ret != bytes) {
 		printf("Stream read failed.\n");
 		return VBERROR_UNKNOWN;
 	}
+	boot_perf_add(BootPerfKernelReadUs, timer_us(start));
+	boot_perf_add(BootPerfKernelReadBytes, bytes);
 	return VBERROR_SUCCESS;
 }
 
@@ -126,4 +143,6 @@ void VbExStreamClose(VbExStream_t stream)
 {
 	StreamOps *dev = (StreamOps *)stream;
 	dev->close(dev);
+	boot_perf_add(BootPerfKernelStreamUs, timer_us(stream_open_us));
+	timestamp_add_now(TS_KERNEL_READ_DONE);
 }
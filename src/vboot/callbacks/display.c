@@ -27,6 +27,8 @@
 #include <vboot_struct.h>
 
 #include "base/cleanup_funcs.h"
+#include "base/init_funcs.h"
+#include "base/timestamp.h"
 #include "drivers/video/coreboot_fb.h"
 #include "drivers/video/display.h"
 #include "vboot/firmware_id.h"
@@ -35,6 +37,12 @@
 
 VbError_t VbExDisplayInit(uint32_t *width, uint32_t *height)
 {
+	timestamp_add_now(TS_DISPLAY_INIT);
+
+	// Once there's a UI, anything deferred may be needed.
+	if (run_deferred_init_funcs())
+		printf("Deferred init funcs failed.\n");
+
 	if (display_init())
 		return VBERROR_UNKNOWN;
 
@@ -44,6 +52,10 @@ VbError_t VbExDisplayInit(uint32_t *width, uint32_t *height)
 	if (gbb_copy_in_bmp_block())
 		return VBERROR_UNKNOWN;
 
+	// The debug info screen shows digests of both keys.
+	if (gbb_copy_in_root_key() || gbb_copy_in_recovery_key())
+		return VBERROR_UNKNOWN;
+
 	if (lib_sysinfo.framebuffer) {
 		*width = lib_sysinfo.framebuffer->x_resolution;
 		*height = lib_sysinfo.framebuffer->y_resolution;
@@ -51,6 +63,7 @@ VbError_t VbExDisplayInit(uint32_t *width, uint32_t *height)
 		*width = *height = 0;
 	}
 
+	timestamp_add_now(TS_DISPLAY_INIT_DONE);
 	return VBERROR_SUCCESS;
 }
 
@@ -28,6 +28,7 @@
 #include <stddef.h>
 #include <vb2_api.h>
 
+#include "base/init_funcs.h"
 #include "base/timestamp.h"
 #include "config.h"
 #include "drivers/ec/cros/ec.h"
@@ -48,21 +49,10 @@ static const char *get_fw_filename(int devidx)
 static struct cbfs_file *get_file_from_cbfs(const char *fmap_name,
 	const char *filename)
 {
-	struct cbfs_media media;
-	struct cbfs_file *file;
-
 	if (!IS_ENABLED(CONFIG_DRIVER_CBFS_FLASH))
 		return NULL;
 
-	if (cbfs_media_from_fmap(&media, fmap_name)) {
-		printf("couldn't access cbfs media\n");
-		return NULL;
-	}
-
-	file = cbfs_get_file(&media, filename);
-	media.close(&media);
-
-	return file;
+	return cbfs_index_get_file(fmap_name, filename);
 }
 
 static const uint8_t *get_file_hash_from_cbfs(const char *fmap_name,
@@ -135,6 +125,8 @@ VbError_t VbExEcRunningRW(int devidx, int *in_rw)
 
 VbError_t VbExEcJumpToRW(int devidx)
 {
+	timestamp_add_now(TS_VB_EC_JUMP_TO_RW);
+
 	if (cros_ec_reboot(devidx, EC_REBOOT_JUMP_RW, 0) < 0) {
 		printf("Failed to make the EC jump to RW.\n");
 		return VBERROR_UNKNOWN;
@@ -153,6 +145,26 @@ VbError_t VbExEcDisableJump(int devidx)
 	return VBERROR_SUCCESS;
 }
 
+/*
+ * Hashing the RW image takes the EC a while, so get it started as early as
+ * possible. By the time software sync asks for it in VbExEcHashRW() it's
+ * usually finished.
+ */
+static int ec_start_hash(void)
+{
+	if (cros_ec_start_hash(0) < 0)
+		printf("Failed to start EC hash.\n");
+
+	if (CONFIG_DRIVER_EC_CROS_PASSTHRU && cros_ec_start_hash(1) < 0)
+		printf("Failed to start PD hash.\n");
+
+	/* Not fatal, VbExEcHashRW() will request the hash again. */
+	return 0;
+}
+
+// The EC is only reachable once the board has set it up.
+INIT_FUNC_AFTER(ec_start_hash, "board_setup");
+
 VbError_t VbExEcHashRW(int devidx, const uint8_t **hash, int *hash_size)
 {
 	static struct ec_response_vboot_hash resp;
@@ -163,13 +175,7 @@ VbError_t VbExEcHashRW(int devidx, const uint8_t **hash, int *hash_size)
 	}
 
 	/*
-	 * TODO (rspangler@chromium.org): the code below isn't very tolerant
-	 * of errors.
-	 *
-	 * If the EC is busy calculating a hash, we should wait and retry
-	 * reading the hash status.
-	 *
-	 * If the hash is unavailable, the wrong type, or covers the wrong
+	 * TODO (rspangler@chromium.org): If the hash covers the wrong
 	 * offset/size (which we need to get from the FDT, since it's
 	 * board-specific), we should request a new hash and wait for it to
 	 * finish.  Also need a flag to force it to rehash, which we'll use
@@ -187,6 +193,7 @@ VbError_t VbExEcHashRW(int devidx, const uint8_t **hash, int *hash_size)
 	*hash = resp.hash_digest;
 	*hash_size = resp.digest_size;
 
+	timestamp_add_now(TS_VB_EC_HASH_READ);
 	return VBERROR_SUCCESS;
 }
 
@@ -337,6 +344,8 @@ VbError_t VbExEcUpdateRW(int devidx, const uint8_t *image, int image_size)
 {
 	int rv;
 
+	timestamp_add_now(TS_VB_EC_UPDATE);
+
 	rv = ec_protect_rw(devidx, 0);
 	if (rv == VBERROR_EC_REBOOT_TO_RO_REQUIRED || rv != VBERROR_SUCCESS)
 		return rv;
@@ -346,11 +355,13 @@ VbError_t VbExEcUpdateRW(int devidx, const uint8_t *image, int image_size)
 		return VBERROR_UNKNOWN;
 	}
 
+	timestamp_add_now(TS_VB_EC_UPDATE_DONE);
 	return VBERROR_SUCCESS;
 }
 
 VbError_t VbExEcProtectRW(int devidx)
 {
+	timestamp_add_now(TS_VB_EC_PROTECT);
 	return ec_protect_rw(devidx, 1);
 }
 
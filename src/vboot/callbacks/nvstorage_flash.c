@@ -32,39 +32,137 @@
  * zero. Changing bits from zero to one requires an erase operation, which
  * affects entire blocks of storage.
  *
- * In a typical case the last non-erased blob of CONFIG_NVRAM_BLOCK_SIZE bytes
- * in the dedicated block is considered the current NVRAM contents. If there
- * is a need to change the NVRAM contents, the next blob worth of bytes is
- * written. It becomes the last non-erased blob, which is by definition the
- * current NVRAM contents.
+ * In a typical case the last non-erased blob of VBNV_BLOCK_SIZE bytes before
+ * the first erased one in the dedicated area is considered the current NVRAM
+ * contents. If there is a need to change the NVRAM contents, the next blob
+ * worth of bytes is written. It becomes the last non-erased blob, which is by
+ * definition the current NVRAM contents. This layout is shared with coreboot
+ * and the user space tools, so the on-flash format can't change.
  *
- * If the entire dedicated block is empty, the first blob is used as the
+ * If the entire dedicated area is empty, the first blob is used as the
  * NVRAM. It will be considered invalid and overwritten by vboot as required.
  *
- * If there is no room in the dedicated block to store a new blob - the NVRAM
- * write operation would fail.
- *
- * This scheme expects the user space application to manage the allocated
- * block, erasing it and initializing the lowest blob with the current NVRAM
- * contents once it gets close to capacity.
+ * Blobs are always appended sequentially and the whole area is erased when
+ * it fills up, so the written blobs form a prefix of the area followed by
+ * erased space. That makes it possible to find the end of the log by
+ * checking the last blob of each erase sector and binary searching the first
+ * one with room, instead of reading the whole area. Coreboot and the user
+ * space tools append the same way, so the area can't be erased piecemeal
+ * without leaving stale blobs they would take as current.
  *
+ * Each blob carries its own signature and CRC. If the newest blob fails
+ * those checks (say, because of a torn write) the newest valid one before
+ * it in the same sector is used instead.
  */
 
+/* Offset and layout of the vboot NV blob header and CRC. */
+enum {
+	NVRAM_HEADER_OFFSET = 0,
+	NVRAM_HEADER_MASK = 0xc0,
+	NVRAM_HEADER_SIGNATURE = 0x40,
+	NVRAM_CRC_OFFSET = 15,
+};
+
 /* FMAP descriptor of the NVRAM area */
 static FmapArea nvram_area_descriptor;
 
+/* Size of the erase units the NVRAM area is managed in. */
+static uint32_t nvram_sector_size;
+
 /* Offset of the actual NVRAM blob offset in the NVRAM block. */
 static int nvram_blob_offset;
 
+/* Offset of the first erased blob following the end of the log. */
+static uint32_t nvram_next_offset;
+
 /* Local cache of the NVRAM blob. */
 static uint8_t nvram_cache[VBNV_BLOCK_SIZE];
 
+static uint8_t nvram_crc8(const uint8_t *data, int len)
+{
+	unsigned crc = 0;
+	int i, j;
+
+	for (j = 0; j < len; j++) {
+		crc ^= data[j] << 8;
+		for (i = 0; i < 8; i++) {
+			if (crc & 0x8000)
+				crc ^= 0x1070 << 3;
+			crc <<= 1;
+		}
+	}
+
+	return (uint8_t)(crc >> 8);
+}
+
+static int nvram_blob_is_valid(const uint8_t *blob)
+{
+	if ((blob[NVRAM_HEADER_OFFSET] & NVRAM_HEADER_MASK) !=
+	    NVRAM_HEADER_SIGNATURE)
+		return 0;
+
+	return nvram_crc8(blob, NVRAM_CRC_OFFSET) == blob[NVRAM_CRC_OFFSET];
+}
+
+static const uint8_t *nvram_read_blob(uint32_t offset)
+{
+	return flash_read(nvram_area_descriptor.offset + offset,
+			  sizeof(nvram_cache));
+}
+
+/* Returns 1 if the blob is erased, 0 if not, and -1 on error. */
+static int nvram_blob_is_erased(uint32_t offset)
+{
+	const uint8_t *blob = nvram_read_blob(offset);
+	int i;
+
+	if (!blob)
+		return -1;
+
+	for (i = 0; i < sizeof(nvram_cache); i++)
+		if (blob[i] != 0xff)
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Find the first erased blob in the sector starting at "start". Returns the
+ * end of the sector if it's full, or -1 on error.
+ */
+static int nvram_find_sector_frontier(uint32_t start)
+{
+	uint32_t blobs = nvram_sector_size / sizeof(nvram_cache);
+	uint32_t low = 0, high = blobs - 1;
+	int erased;
+
+	erased = nvram_blob_is_erased(start + high * sizeof(nvram_cache));
+	if (erased < 0)
+		return -1;
+	if (!erased)
+		return start + nvram_sector_size;
+
+	while (low < high) {
+		uint32_t mid = (low + high) / 2;
+
+		erased = nvram_blob_is_erased(start + mid * sizeof(nvram_cache));
+		if (erased < 0)
+			return -1;
+		if (erased)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	return start + low * sizeof(nvram_cache);
+}
+
 static int flash_nvram_init(void)
 {
-	int area_offset, prev_offset, size_limit;
 	static int vbnv_flash_is_initialized = 0;
-	uint8_t empty_nvram_block[sizeof(nvram_cache)];
-	uint8_t *nvram_area_in_flash;
+	uint32_t area_size, sector, offset;
+	const uint8_t *blob;
+	int frontier;
 
 	if (vbnv_flash_is_initialized)
 		return 0;
@@ -73,37 +171,63 @@ static int flash_nvram_init(void)
 		printf("%s: failed to find NVRAM area\n", __func__);
 		return -1;
 	}
+	area_size = ALIGN_DOWN(nvram_area_descriptor.size,
+			       sizeof(nvram_cache));
 
-	nvram_area_in_flash = flash_read(nvram_area_descriptor.offset,
-					 nvram_area_descriptor.size);
-	if (!nvram_area_in_flash) {
-		printf("%s: failed to read NVRAM area\n", __func__);
-		return -1;
+	/*
+	 * Fall back to treating the whole area as a single sector if it
+	 * doesn't divide into erase sectors evenly.
+	 */
+	nvram_sector_size = flash_sector_size();
+	if (!nvram_sector_size ||
+	    nvram_sector_size % sizeof(nvram_cache) ||
+	    nvram_area_descriptor.offset % nvram_sector_size ||
+	    area_size % nvram_sector_size)
+		nvram_sector_size = area_size;
+
+	/* Find the first sector with some erased space in it. */
+	frontier = area_size;
+	for (sector = 0; sector < area_size; sector += nvram_sector_size) {
+		frontier = nvram_find_sector_frontier(sector);
+		if (frontier < 0) {
+			printf("%s: failed to read NVRAM area\n", __func__);
+			return -1;
+		}
+		if (frontier < sector + nvram_sector_size)
+			break;
 	}
 
-	/* Prepare an empty NVRAM block to compare against. */
-	memset(empty_nvram_block, 0xff, sizeof(empty_nvram_block));
+	nvram_next_offset = frontier;
+	nvram_blob_offset = frontier ? frontier - sizeof(nvram_cache) : 0;
 
 	/*
-	 * Now find the first completely empty NVRAM blob. The actual NVRAM
-	 * blob will be right below it.
+	 * Skip back over any corrupted blobs at the end of the log, but
+	 * don't leave the sector the newest blob is in.
 	 */
-	size_limit = nvram_area_descriptor.size - sizeof(nvram_cache);
-	for (area_offset = 0, prev_offset = 0;
-	     area_offset <= size_limit;
-	     area_offset += sizeof(nvram_cache)) {
-		if (!memcmp(nvram_area_in_flash + area_offset,
-			    empty_nvram_block,
-			    sizeof(nvram_cache)))
+	sector = ALIGN_DOWN(nvram_blob_offset, nvram_sector_size);
+	for (offset = nvram_blob_offset; ; offset -= sizeof(nvram_cache)) {
+		blob = nvram_read_blob(offset);
+		if (!blob) {
+			printf("%s: failed to read NVRAM area\n", __func__);
+			return -1;
+		}
+		if (nvram_blob_is_valid(blob) || offset == sector)
 			break;
-		prev_offset = area_offset;
+	}
+	if (offset != nvram_blob_offset) {
+		if (nvram_blob_is_valid(blob)) {
+			printf("%s: skipping corrupted NVRAM blob(s)\n",
+			       __func__);
+			nvram_blob_offset = offset;
+		} else {
+			blob = nvram_read_blob(nvram_blob_offset);
+			if (!blob)
+				return -1;
+		}
 	}
 
-	memcpy(nvram_cache,
-	       nvram_area_in_flash + prev_offset,
-	       sizeof(nvram_cache));
+	memcpy(nvram_cache, blob, sizeof(nvram_cache));
 
-	nvram_blob_offset = prev_offset;
 	vbnv_flash_is_initialized = 1;
 	return 0;
 }
@@ -119,9 +243,6 @@ VbError_t VbExNvStorageRead(uint8_t *buf)
 
 static VbError_t erase_nvram(void)
 {
-	if (flash_nvram_init())
-		return VBERROR_UNKNOWN;
-
 	if (flash_erase(nvram_area_descriptor.offset,
 			nvram_area_descriptor.size) !=
 					nvram_area_descriptor.size)
@@ -132,6 +253,8 @@ static VbError_t erase_nvram(void)
 
 VbError_t VbExNvStorageWrite(const uint8_t *buf)
 {
+	uint32_t area_size;
+	int can_overwrite;
 	int i;
 
 	if (flash_nvram_init())
@@ -141,25 +264,31 @@ VbError_t VbExNvStorageWrite(const uint8_t *buf)
 	if (!memcmp(buf, nvram_cache, sizeof(nvram_cache)))
 		return VBERROR_SUCCESS;
 
-	/* See if we can overwrite the current blob with the new one. */
+	/*
+	 * See if we can overwrite the current blob with the new one. That's
+	 * only safe if it's the last one in the log.
+	 */
+	can_overwrite = (nvram_blob_offset + sizeof(nvram_cache) ==
+			 nvram_next_offset);
 	for (i = 0; i < sizeof(nvram_cache); i++)
 		if ((nvram_cache[i] & buf[i]) != buf[i])
-			break;
+			can_overwrite = 0;
 
-	if (i != sizeof(nvram_cache)) {
-		int new_blob_offset;
+	if (!can_overwrite) {
 		/*
 		 * Won't be able to overwrite, need to use the next blob,
 		 * let's see if it is available.
 		 */
-		new_blob_offset = nvram_blob_offset + sizeof(nvram_cache);
-		if (new_blob_offset >= nvram_area_descriptor.size) {
+		area_size = ALIGN_DOWN(nvram_area_descriptor.size,
+				       sizeof(nvram_cache));
+		if (nvram_next_offset >= area_size) {
 			printf("nvram is used up. deleting it to start over\n");
 			if (erase_nvram() != VBERROR_SUCCESS)
 				return VBERROR_UNKNOWN;
-			new_blob_offset = 0;
+			nvram_next_offset = 0;
 		}
-		nvram_blob_offset = new_blob_offset;
+		nvram_blob_offset = nvram_next_offset;
+		nvram_next_offset += sizeof(nvram_cache);
 	}
 
 	if (flash_write(nvram_area_descriptor.offset + nvram_blob_offset,
@@ -23,6 +23,7 @@
 #include <libpayload.h>
 #include <vboot_api.h>
 
+#include "base/timestamp.h"
 #include "drivers/tpm/tpm.h"
 
 VbError_t VbExTpmInit(void)
@@ -32,11 +33,13 @@ VbError_t VbExTpmInit(void)
 
 VbError_t VbExTpmClose(void)
 {
+	timestamp_add_now(TS_TPM_CLOSE);
 	return VBERROR_SUCCESS;
 }
 
 VbError_t VbExTpmOpen(void)
 {
+	timestamp_add_now(TS_TPM_OPEN);
 	return VBERROR_SUCCESS;
 }
 
@@ -29,6 +29,7 @@
 #include <vboot_api.h>
 #include <vboot_struct.h>
 
+#include "base/boot_perf.h"
 #include "base/device_tree.h"
 #include "config.h"
 #include "image/fmap.h"
@@ -44,6 +45,7 @@ static int install_crossystem_data(DeviceTreeFixup *fixup, DeviceTree *tree)
 	DeviceTreeNode *node = dt_find_node(tree->root, path, NULL, NULL, 1);
 
 	dt_add_string_prop(node, "compatible", "chromeos-firmware");
+	boot_perf_add_dt_props(node);
 
 	void *blob;
 	int size;
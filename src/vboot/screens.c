@@ -26,6 +26,7 @@
 #include <vboot_api.h>
 #include <vboot/screens.h>
 #include "base/graphics.h"
+#include "drivers/flash/cbfs.h"
 #include "drivers/video/display.h"
 #include "vboot/util/commonparams.h"
 
@@ -88,8 +89,7 @@ static VbError_t load_archive(const char *name, struct directory **dest)
 	*dest = NULL;
 
 	/* load archive from cbfs */
-	dir = cbfs_get_file_content(CBFS_DEFAULT_MEDIA, name,
-				  CBFS_TYPE_RAW, &size);
+	dir = cbfs_index_get_file_content(NULL, name, CBFS_TYPE_RAW, &size);
 	if (!dir || !size) {
 		printf("%s: failed to load %s\n", __func__, name);
 		return VBERROR_INVALID_BMPFV;
@@ -743,8 +743,8 @@ static void vboot_init_locale(void)
 	locale_data.count = 0;
 
 	/* Load locale list from cbfs */
-	locales = cbfs_get_file_content(CBFS_DEFAULT_MEDIA, "locales",
-					CBFS_TYPE_RAW, &size);
+	locales = cbfs_index_get_file_content(NULL, "locales",
+					      CBFS_TYPE_RAW, &size);
 	if (!locales || !size) {
 		printf("%s: locale list not found\n", __func__);
 		return;
@@ -26,6 +26,7 @@
 #include <vboot_api.h>
 #include <vboot_nvstorage.h>
 
+#include "base/init_funcs.h"
 #include "base/timestamp.h"
 #include "boot/commandline.h"
 #include "config.h"
@@ -99,6 +100,9 @@ int vboot_init(void)
         if (!CONFIG_PHYSICAL_REC_SWITCH)
                 iparams.flags |= VB_INIT_FLAG_VIRTUAL_REC_SWITCH;
 
+	// vboot reads and writes NV storage itself; don't let it see stale data.
+	vbnv_flush();
+
 	printf("Calling VbInit().\n");
 	VbError_t res = VbInit(&cparams, &iparams);
 	if (res != VBERROR_SUCCESS) {
@@ -123,6 +127,9 @@ int vboot_in_developer(void)
 void vboot_update_recovery(uint32_t request)
 {
 	vbnv_write(VBNV_RECOVERY_REQUEST, request);
+	// Callers may be outside the vboot flow, so don't count on a later
+	// flush.
+	vbnv_flush();
 }
 
 int vboot_do_init_out_flags(uint32_t out_flags)
@@ -168,8 +175,15 @@ int vboot_select_firmware(void)
 		flash_read(vblock_b.offset, vblock_b.size);
 	fparams.verification_size_B = vblock_b.size;
 
+	// The root key is only needed to verify the RW firmware.
+	if (gbb_copy_in_root_key())
+		return 1;
+
+	vbnv_flush();
+
 	printf("Calling VbSelectFirmware().\n");
 	VbError_t res = VbSelectFirmware(&cparams, &fparams);
+	timestamp_add_now(TS_RO_VB_SELECT_FIRMWARE_DONE);
 	if (res != VBERROR_SUCCESS) {
 		printf("VbSelectFirmware returned %d, "
 		       "Doing a cold reboot.\n", res);
@@ -212,8 +226,15 @@ int vboot_select_and_load_kernel(void)
 		.kernel_buffer_size = &_kernel_end - &_kernel_start
 	};
 
+	// The recovery key is only needed to verify recovery kernels.
+	if (vboot_in_recovery() && gbb_copy_in_recovery_key())
+		return 1;
+
+	vbnv_flush();
+
 	printf("Calling VbSelectAndLoadKernel().\n");
 	VbError_t res = VbSelectAndLoadKernel(&cparams, &kparams);
+	timestamp_add_now(TS_VB_SELECT_AND_LOAD_KERNEL_DONE);
 	if (res == VBERROR_EC_REBOOT_TO_RO_REQUIRED) {
 		printf("Rebooting the EC to RO.\n");
 		reboot_ec_to_ro();
@@ -243,6 +264,10 @@ void vboot_boot_kernel(VbSelectAndLoadKernelParams *kparams)
 
 	timestamp_add_now(TS_CROSSYSTEM_DATA);
 
+	// Device tree fixups and the like may still be waiting.
+	if (run_deferred_init_funcs())
+		printf("Deferred init funcs failed.\n");
+
 	memset(&bi, 0, sizeof(bi));
 
 	if (fill_boot_info(&bi, kparams) == -1) {
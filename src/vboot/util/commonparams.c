@@ -63,6 +63,20 @@ static void gbb_copy_out(uint32_t gbb_offset, uint32_t offset, uint32_t size)
 	return;
 }
 
+/*
+ * GBB components other than the header and HWID are only copied in when
+ * they're needed, so a normal mode boot never reads the keys or the bitmap
+ * block from flash.
+ */
+enum {
+	GbbRootKey = 1 << 0,
+	GbbRecoveryKey = 1 << 1,
+	GbbBmpBlock = 1 << 2
+};
+
+static uint32_t gbb_components_loaded;
+static uint32_t gbb_flash_offset;
+
 static int gbb_init(void)
 {
 	static int initialized = 0;
@@ -96,17 +110,48 @@ static int gbb_init(void)
 		printf(" %02x", header->signature[i]);
 	printf("\n");
 
+	// The HWID is small and needed on every boot for crossystem.
 	if (!gbb_copy_in(offset, header->hwid_offset, header->hwid_size))
 		return 1;
 
-	if (!gbb_copy_in(offset, header->rootkey_offset, header->rootkey_size))
+	gbb_flash_offset = offset;
+	gbb_components_loaded = 0;
+	initialized = 1;
+	return 0;
+}
+
+static int gbb_copy_in_component(uint32_t component)
+{
+	if (gbb_init())
 		return 1;
 
-	if (!gbb_copy_in(offset, header->recovery_key_offset,
-			 header->recovery_key_size))
+	if (gbb_components_loaded & component)
+		return 0;
+
+	GoogleBinaryBlockHeader *header = cparams.gbb_data;
+	uint32_t offset, size;
+
+	switch (component) {
+	case GbbRootKey:
+		offset = header->rootkey_offset;
+		size = header->rootkey_size;
+		break;
+	case GbbRecoveryKey:
+		offset = header->recovery_key_offset;
+		size = header->recovery_key_size;
+		break;
+	case GbbBmpBlock:
+		offset = header->bmpfv_offset;
+		size = header->bmpfv_size;
+		break;
+	default:
 		return 1;
+	}
 
-	initialized = 1;
+	if (!gbb_copy_in(gbb_flash_offset, offset, size))
+		return 1;
+
+	gbb_components_loaded |= component;
 	return 0;
 }
 
@@ -131,22 +176,19 @@ int gbb_clear_flags(void)
 	return 0;
 }
 
-int gbb_copy_in_bmp_block(void)
+int gbb_copy_in_root_key(void)
 {
-	FmapArea area;
-	if (fmap_find_area("GBB", &area)) {
-		printf("Couldn't find the GBB.\n");
-		return 1;
-	}
-
-	GoogleBinaryBlockHeader *header =
-		(GoogleBinaryBlockHeader *)cparams.gbb_data;
+	return gbb_copy_in_component(GbbRootKey);
+}
 
-	if (!gbb_copy_in(area.offset, header->bmpfv_offset,
-			 header->bmpfv_size))
-		return 1;
+int gbb_copy_in_recovery_key(void)
+{
+	return gbb_copy_in_component(GbbRecoveryKey);
+}
 
-	return 0;
+int gbb_copy_in_bmp_block(void)
+{
+	return gbb_copy_in_component(GbbBmpBlock);
 }
 
 static int cparams_initialized = 0;
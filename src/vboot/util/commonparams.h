@@ -30,7 +30,14 @@
 extern VbCommonParams cparams;
 extern uint8_t shared_data_blob[VB_SHARED_DATA_REC_SIZE];
 
-int gbb_copy_in_bmp_block();
+/*
+ * Only the GBB header and HWID are copied in by common_params_init(). These
+ * copy in the other components before vboot needs them. Returns non-zero on
+ * failure.
+ */
+int gbb_copy_in_root_key(void);
+int gbb_copy_in_recovery_key(void);
+int gbb_copy_in_bmp_block(void);
 int common_params_init(int clear_shared_data);
 int is_cparams_initialized(void);
 // Implemented by each arch.
@@ -24,37 +24,81 @@
 #include <vboot_api.h>
 #include <vboot_nvstorage.h>
 
+#include "base/cleanup_funcs.h"
 #include "vboot/vbnv.h"
 
-uint32_t vbnv_read(uint32_t flag)
+/*
+ * The NV context is read from the backing store once, on first use, and kept
+ * in memory until it's flushed. Updates only touch the cached copy, so a
+ * sequence of flag changes costs at most one write to the (often slow) EC or
+ * flash backed storage.
+ */
+static VbNvContext context;
+static int context_loaded;
+
+static int vbnv_cleanup(CleanupFunc *cleanup, CleanupType type)
 {
-	uint32_t val;
-	VbNvContext context;
+	return vbnv_flush();
+}
+
+static CleanupFunc vbnv_cleanup_func = {
+	&vbnv_cleanup,
+	CleanupOnReboot | CleanupOnPowerOff |
+	CleanupOnHandoff | CleanupOnLegacy,
+	NULL
+};
+
+static void vbnv_setup(void)
+{
+	static int cleanup_registered;
+
+	if (context_loaded)
+		return;
 
 	VbExNvStorageRead(context.raw);
 	VbNvSetup(&context);
+	context_loaded = 1;
 
-	VbNvGet(&context, flag, &val);
+	if (!cleanup_registered) {
+		list_insert_after(&vbnv_cleanup_func.list_node,
+				  &cleanup_funcs);
+		cleanup_registered = 1;
+	}
+}
 
-	VbNvTeardown(&context);
-	if (context.raw_changed)
-		VbExNvStorageWrite(context.raw);
+uint32_t vbnv_read(uint32_t flag)
+{
+	uint32_t val;
+
+	vbnv_setup();
+	VbNvGet(&context, flag, &val);
 
 	return val;
 }
 
 void vbnv_write(uint32_t flag, uint32_t val)
 {
-	VbNvContext context;
+	vbnv_setup();
+	VbNvSet(&context, flag, val);
+}
 
-	VbExNvStorageRead(context.raw);
-	VbNvSetup(&context);
+int vbnv_flush(void)
+{
+	if (!context_loaded)
+		return 0;
 
-	VbNvSet(&context, flag, val);
+	/*
+	 * Drop the cached copy even if the write fails so the next access
+	 * goes back to the backing store rather than trusting stale data.
+	 */
+	context_loaded = 0;
 
 	VbNvTeardown(&context);
-	if (context.raw_changed)
-		VbExNvStorageWrite(context.raw);
-}
-
+	if (context.raw_changed &&
+	    VbExNvStorageWrite(context.raw) != VBERROR_SUCCESS) {
+		printf("%s: Failed to write back NV storage.\n", __func__);
+		return 1;
+	}
 
+	return 0;
+}
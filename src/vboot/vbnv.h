@@ -26,4 +26,14 @@
 uint32_t vbnv_read(uint32_t flag);
 void vbnv_write(uint32_t flag, uint32_t val);
 
+/*
+ * Write any pending changes made through vbnv_write() back to NV storage and
+ * drop the cached context. This happens automatically on reboot, power off
+ * and kernel handoff, but it also needs to be done before handing control to
+ * the vboot library, which accesses NV storage directly. Writes made outside
+ * the normal vboot flow should be flushed right away, since the session may
+ * end with a power loss instead. Returns non-zero on failure.
+ */
+int vbnv_flush(void);
+
 #endif /* __VBOOT_VBNV_H__ */
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/device_tree.h"
+#include "harness.h"
+#include "tree.h"
+
+static void test_round_trip(void)
+{
+	DeviceTree *tree = test_tree_new();
+	DeviceTreeNode *cpus = dt_find_node_by_path(tree->root, "cpus",
+						    NULL, NULL, 1);
+	dt_add_u32_prop(cpus, "#address-cells", 1);
+	dt_add_u32_prop(cpus, "#size-cells", 0);
+	DeviceTreeNode *cpu = dt_find_node_by_path(tree->root, "cpus/cpu@0",
+						   NULL, NULL, 1);
+	dt_add_string_prop(cpu, "compatible", "arm,cortex-a53");
+	dt_add_u32_prop(cpu, "reg", 0);
+	u64 addr = 0x80000000, size = 0x40000000;
+	DeviceTreeNode *memory = dt_find_node_by_path(tree->root, "memory",
+						      NULL, NULL, 1);
+	dt_add_reg_prop(memory, &addr, &size, 1, 2, 2);
+
+	uint32_t blob_size;
+	void *blob = test_tree_flatten(tree, &blob_size);
+	CHECK_EQ(betohl(((FdtHeader *)blob)->magic), FdtMagic);
+	CHECK_EQ(betohl(((FdtHeader *)blob)->totalsize), blob_size);
+
+	DeviceTree *copy = fdt_unflatten(blob);
+	CHECK(copy && copy->root);
+
+	u32 addr_cells = 0, size_cells = 0;
+	DeviceTreeNode *found = dt_find_node_by_path(copy->root, "cpus/cpu@0",
+						     &addr_cells, &size_cells,
+						     0);
+	CHECK(found);
+	CHECK_EQ(addr_cells, 1);
+	CHECK_EQ(size_cells, 0);
+	CHECK_STR_EQ(dt_find_string_prop(found, "compatible"),
+		     "arm,cortex-a53");
+
+	void *data;
+	size_t data_size;
+	found = dt_find_node_by_path(copy->root, "memory", NULL, NULL, 0);
+	CHECK(found);
+	dt_find_bin_prop(found, "reg", &data, &data_size);
+	CHECK_EQ(data_size, 16);
+	CHECK_EQ(betohll(((uint64_t *)data)[0]), addr);
+	CHECK_EQ(betohll(((uint64_t *)data)[1]), size);
+
+	// Flattening what was unflattened gives back the same bytes.
+	uint32_t again_size;
+	void *again = test_tree_flatten(copy, &again_size);
+	CHECK_EQ(again_size, blob_size);
+	CHECK(!memcmp(again, blob, blob_size));
+
+	free(again);
+	free(blob);
+}
+
+static void test_reserve_map(void)
+{
+	DeviceTree *tree = test_tree_new();
+	DeviceTreeReserveMapEntry entries[2] = {
+		{ 0x1000, 0x2000 }, { 0x100000000ULL, 0x10000 }
+	};
+	list_insert_after(&entries[1].list_node, &tree->reserve_map);
+	list_insert_after(&entries[0].list_node, &tree->reserve_map);
+
+	void *blob = test_tree_flatten(tree, NULL);
+	DeviceTree *copy = fdt_unflatten(blob);
+
+	DeviceTreeReserveMapEntry *entry;
+	int i = 0;
+	list_for_each(entry, copy->reserve_map, list_node) {
+		CHECK(i < ARRAY_SIZE(entries));
+		CHECK_EQ(entry->start, entries[i].start);
+		CHECK_EQ(entry->size, entries[i].size);
+		i++;
+	}
+	CHECK_EQ(i, ARRAY_SIZE(entries));
+	free(blob);
+}
+
+static void test_flat_walk(void)
+{
+	DeviceTree *tree = test_tree_new();
+	DeviceTreeNode *node = dt_find_node_by_path(tree->root, "a/b",
+						    NULL, NULL, 1);
+	dt_add_u32_prop(node, "x", 0x12345678);
+	dt_add_string_prop(tree->root, "model", "host");
+
+	void *blob = test_tree_flatten(tree, NULL);
+	uint32_t offset = betohl(((FdtHeader *)blob)->structure_offset);
+
+	const char *name;
+	int size = fdt_node_name(blob, offset, &name);
+	CHECK(size);
+	CHECK_STR_EQ(name, "");
+
+	FdtProperty prop;
+	size = fdt_next_property(blob, offset + size, &prop);
+	CHECK(size);
+	CHECK_STR_EQ(prop.name, "model");
+	CHECK_EQ(prop.size, sizeof("host"));
+
+	// Skipping the root covers the whole structure block.
+	CHECK_EQ(fdt_skip_node(blob, offset),
+		 betohl(((FdtHeader *)blob)->structure_size));
+	free(blob);
+}
+
+static void test_find_node_create(void)
+{
+	DeviceTree *tree = test_tree_new();
+
+	CHECK(!dt_find_node_by_path(tree->root, "x/y", NULL, NULL, 0));
+	DeviceTreeNode *y = dt_find_node_by_path(tree->root, "x/y",
+						 NULL, NULL, 1);
+	CHECK(y);
+	CHECK_STR_EQ(y->name, "y");
+	CHECK(dt_find_node_by_path(tree->root, "x/y", NULL, NULL, 0) == y);
+
+	const char *path[] = { "x", NULL };
+	DeviceTreeNode *x = dt_find_node(tree->root, path, NULL, NULL, 0);
+	CHECK(x);
+	CHECK(x->children.next == &y->list_node);
+}
+
+static void test_find_compat(void)
+{
+	DeviceTree *tree = test_tree_new();
+	static char compat[] = "vendor,first\0vendor,second";
+
+	DeviceTreeNode *a = dt_find_node_by_path(tree->root, "soc/a",
+						 NULL, NULL, 1);
+	DeviceTreeNode *b = dt_find_node_by_path(tree->root, "soc/b",
+						 NULL, NULL, 1);
+	dt_add_bin_prop(a, "compatible", compat, sizeof(compat));
+	dt_add_bin_prop(b, "compatible", compat, sizeof(compat));
+
+	// Any string in the list matches.
+	DeviceTreeNode *found = dt_find_compat(tree->root, "vendor,second");
+	CHECK(found == a || found == b);
+	CHECK(!dt_find_compat(tree->root, "vendor,third"));
+
+	DeviceTreeNode *soc = dt_find_node_by_path(tree->root, "soc",
+						   NULL, NULL, 0);
+	DeviceTreeNode *first = dt_find_next_compat_child(soc, NULL,
+							  "vendor,first");
+	CHECK(first);
+	DeviceTreeNode *second = dt_find_next_compat_child(soc, first,
+							   "vendor,first");
+	CHECK(second && second != first);
+	CHECK(!dt_find_next_compat_child(soc, second, "vendor,first"));
+}
+
+static void test_find_prop_value(void)
+{
+	DeviceTree *tree = test_tree_new();
+	DeviceTreeNode *node = dt_find_node_by_path(tree->root, "a/b/c",
+						    NULL, NULL, 1);
+	dt_add_u32_prop(node, "phandle", 7);
+
+	u32 phandle = htobel(7);
+	CHECK(dt_find_prop_value(tree->root, "phandle", &phandle,
+				 sizeof(phandle)) == node);
+	phandle = htobel(8);
+	CHECK(!dt_find_prop_value(tree->root, "phandle", &phandle,
+				  sizeof(phandle)));
+}
+
+static void test_update_prop(void)
+{
+	DeviceTree *tree = test_tree_new();
+	static char first[] = "first", second[] = "second";
+
+	dt_add_string_prop(tree->root, "model", first);
+	dt_add_string_prop(tree->root, "model", second);
+
+	int count = 0;
+	DeviceTreeProperty *prop;
+	list_for_each(prop, tree->root->properties, list_node)
+		count++;
+	CHECK_EQ(count, 1);
+	CHECK_STR_EQ(dt_find_string_prop(tree->root, "model"), "second");
+	CHECK(!dt_find_string_prop(tree->root, "missing"));
+
+	static uint8_t mac[6] = { 1, 2, 3, 4, 5, 6 };
+	CHECK(!dt_set_bin_prop_by_path(tree, "ethernet/local-mac-address",
+				       mac, sizeof(mac), 1));
+	DeviceTreeNode *eth = dt_find_node_by_path(tree->root, "ethernet",
+						   NULL, NULL, 0);
+	CHECK(eth);
+	void *data;
+	size_t size;
+	dt_find_bin_prop(eth, "local-mac-address", &data, &size);
+	CHECK_EQ(size, sizeof(mac));
+	CHECK(!memcmp(data, mac, sizeof(mac)));
+}
+
+static void test_write_int(void)
+{
+	uint8_t buf[8];
+
+	dt_write_int(buf, 0x0102030405060708ULL, 8);
+	CHECK_EQ(buf[0], 0x01);
+	CHECK_EQ(buf[7], 0x08);
+
+	// Only the low bytes are kept when the destination is shorter.
+	memset(buf, 0, sizeof(buf));
+	dt_write_int(buf, 0x0102030405060708ULL, 3);
+	CHECK_EQ(buf[0], 0x06);
+	CHECK_EQ(buf[2], 0x08);
+	CHECK_EQ(buf[3], 0);
+}
+
+HostTest host_tests[] = {
+	{ "round_trip", &test_round_trip },
+	{ "reserve_map", &test_reserve_map },
+	{ "flat_walk", &test_flat_walk },
+	{ "find_node_create", &test_find_node_create },
+	{ "find_compat", &test_find_compat },
+	{ "find_prop_value", &test_find_prop_value },
+	{ "update_prop", &test_update_prop },
+	{ "write_int", &test_write_int },
+	{ NULL }
+};
+
+static void *bench_blob(uint32_t *size)
+{
+	static void *blob;
+	static uint32_t blob_size;
+
+	if (!blob)
+		blob = test_tree_flatten(test_tree_new_board(), &blob_size);
+	if (size)
+		*size = blob_size;
+	return blob;
+}
+
+static void bench_unflatten(uint64_t iterations)
+{
+	void *blob = bench_blob(NULL);
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++) {
+		host_alloc_track();
+		DeviceTree *tree = fdt_unflatten(blob);
+		host_bench_sink = (uintptr_t)tree->root;
+		host_alloc_free_tracked();
+	}
+}
+
+static void bench_flatten(uint64_t iterations)
+{
+	uint32_t size;
+	DeviceTree *tree = fdt_unflatten(bench_blob(&size));
+	void *dest = xmalloc(size);
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++) {
+		host_bench_sink = dt_flat_size(tree);
+		dt_flatten(tree, dest);
+	}
+	free(dest);
+}
+
+static void bench_find_node_by_path(uint64_t iterations)
+{
+	DeviceTree *tree = fdt_unflatten(bench_blob(NULL));
+	// The last node among its siblings at every level.
+	const char *path = "soc/bus@0/device@0";
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++) {
+		u32 addr_cells, size_cells;
+		host_bench_sink = (uintptr_t)dt_find_node_by_path(tree->root,
+				path, &addr_cells, &size_cells, 0);
+	}
+}
+
+static void bench_find_compat(uint64_t iterations)
+{
+	DeviceTree *tree = fdt_unflatten(bench_blob(NULL));
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++)
+		host_bench_sink = (uintptr_t)dt_find_compat(tree->root,
+							    "test,last");
+}
+
+HostBench host_benches[] = {
+	{ "unflatten", &bench_unflatten },
+	{ "flatten", &bench_flatten },
+	{ "find_node_by_path", &bench_find_node_by_path },
+	{ "find_compat", &bench_find_compat },
+	{ NULL }
+};
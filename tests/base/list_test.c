@@ -0,0 +1,161 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/list.h"
+#include "harness.h"
+
+typedef struct {
+	int value;
+	ListNode list_node;
+} Item;
+
+enum {
+	BenchItems = 1024
+};
+
+static void test_insert_after(void)
+{
+	ListNode head = { NULL, NULL };
+	Item items[3];
+
+	// Each insert goes at the front.
+	for (int i = 0; i < ARRAY_SIZE(items); i++) {
+		items[i].value = i;
+		list_insert_after(&items[i].list_node, &head);
+	}
+
+	Item *item;
+	int expected = ARRAY_SIZE(items) - 1;
+	list_for_each(item, head, list_node)
+		CHECK_EQ(item->value, expected--);
+	CHECK_EQ(expected, -1);
+	CHECK(items[2].list_node.prev == &head);
+	CHECK(items[0].list_node.next == NULL);
+}
+
+static void test_insert_before(void)
+{
+	ListNode head = { NULL, NULL };
+	Item first = { 0 }, middle = { 1 }, last = { 2 };
+
+	list_insert_after(&last.list_node, &head);
+	list_insert_before(&first.list_node, &last.list_node);
+	list_insert_before(&middle.list_node, &last.list_node);
+
+	Item *item;
+	int expected = 0;
+	list_for_each(item, head, list_node)
+		CHECK_EQ(item->value, expected++);
+	CHECK_EQ(expected, 3);
+	CHECK(last.list_node.prev == &middle.list_node);
+	CHECK(middle.list_node.prev == &first.list_node);
+}
+
+static void test_remove(void)
+{
+	ListNode head = { NULL, NULL };
+	Item items[4];
+
+	for (int i = ARRAY_SIZE(items) - 1; i >= 0; i--) {
+		items[i].value = i;
+		list_insert_after(&items[i].list_node, &head);
+	}
+
+	// Middle, then both ends.
+	list_remove(&items[1].list_node);
+	list_remove(&items[0].list_node);
+	list_remove(&items[3].list_node);
+
+	CHECK(head.next == &items[2].list_node);
+	CHECK(items[2].list_node.prev == &head);
+	CHECK(items[2].list_node.next == NULL);
+
+	list_remove(&items[2].list_node);
+	CHECK(head.next == NULL);
+}
+
+static void test_remove_while_iterating(void)
+{
+	ListNode head = { NULL, NULL };
+	Item items[6];
+
+	for (int i = ARRAY_SIZE(items) - 1; i >= 0; i--) {
+		items[i].value = i;
+		list_insert_after(&items[i].list_node, &head);
+	}
+
+	// Removal leaves the node's own links alone, so iteration goes on.
+	Item *item;
+	list_for_each(item, head, list_node) {
+		if (item->value % 2)
+			list_remove(&item->list_node);
+	}
+
+	int expected = 0;
+	list_for_each(item, head, list_node) {
+		CHECK_EQ(item->value, expected);
+		expected += 2;
+	}
+	CHECK_EQ(expected, 6);
+}
+
+HostTest host_tests[] = {
+	{ "insert_after", &test_insert_after },
+	{ "insert_before", &test_insert_before },
+	{ "remove", &test_remove },
+	{ "remove_while_iterating", &test_remove_while_iterating },
+	{ NULL }
+};
+
+static Item bench_items[BenchItems];
+
+static void bench_build_and_walk(uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; i++) {
+		ListNode head = { NULL, NULL };
+
+		for (int j = 0; j < BenchItems; j++) {
+			bench_items[j].value = j;
+			list_insert_after(&bench_items[j].list_node, &head);
+		}
+
+		Item *item;
+		uint64_t sum = 0;
+		list_for_each(item, head, list_node)
+			sum += item->value;
+		host_bench_sink = sum;
+	}
+}
+
+static void bench_remove_all(uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; i++) {
+		ListNode head = { NULL, NULL };
+
+		for (int j = 0; j < BenchItems; j++)
+			list_insert_after(&bench_items[j].list_node, &head);
+
+		Item *item;
+		list_for_each(item, head, list_node)
+			list_remove(&item->list_node);
+		host_bench_sink = (uintptr_t)head.next;
+	}
+}
+
+HostBench host_benches[] = {
+	{ "build_and_walk_1024", &bench_build_and_walk },
+	{ "build_and_remove_1024", &bench_remove_all },
+	{ NULL }
+};
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/physmem.h"
+#include "base/ranges.h"
+#include "harness.h"
+
+enum {
+	MaxCollected = 16,
+	BenchRanges = 256
+};
+
+typedef struct {
+	int count;
+	uint64_t start[MaxCollected];
+	uint64_t end[MaxCollected];
+} Collected;
+
+static void collect(uint64_t start, uint64_t end, void *data)
+{
+	Collected *collected = data;
+
+	if (collected->count < MaxCollected) {
+		collected->start[collected->count] = start;
+		collected->end[collected->count] = end;
+	}
+	collected->count++;
+}
+
+static Collected collect_all(Ranges *ranges)
+{
+	Collected collected = { 0 };
+
+	ranges_for_each(ranges, &collect, &collected);
+	return collected;
+}
+
+static void test_empty(void)
+{
+	Ranges ranges;
+
+	ranges_init(&ranges);
+	CHECK_EQ(collect_all(&ranges).count, 0);
+	ranges_teardown(&ranges);
+}
+
+static void test_add_disjoint(void)
+{
+	Ranges ranges;
+
+	ranges_init(&ranges);
+	ranges_add(&ranges, 0x3000, 0x4000);
+	ranges_add(&ranges, 0x1000, 0x2000);
+
+	Collected c = collect_all(&ranges);
+	CHECK_EQ(c.count, 2);
+	CHECK_EQ(c.start[0], 0x1000);
+	CHECK_EQ(c.end[0], 0x2000);
+	CHECK_EQ(c.start[1], 0x3000);
+	CHECK_EQ(c.end[1], 0x4000);
+	ranges_teardown(&ranges);
+}
+
+static void test_add_merges(void)
+{
+	Ranges ranges;
+
+	ranges_init(&ranges);
+	ranges_add(&ranges, 0x1000, 0x2000);
+	ranges_add(&ranges, 0x3000, 0x4000);
+	// Touching both neighbours joins everything into one range.
+	ranges_add(&ranges, 0x2000, 0x3000);
+
+	Collected c = collect_all(&ranges);
+	CHECK_EQ(c.count, 1);
+	CHECK_EQ(c.start[0], 0x1000);
+	CHECK_EQ(c.end[0], 0x4000);
+
+	// Covering a range entirely swallows it.
+	ranges_add(&ranges, 0x800, 0x5000);
+	c = collect_all(&ranges);
+	CHECK_EQ(c.count, 1);
+	CHECK_EQ(c.start[0], 0x800);
+	CHECK_EQ(c.end[0], 0x5000);
+	ranges_teardown(&ranges);
+}
+
+static void test_sub_splits(void)
+{
+	Ranges ranges;
+
+	ranges_init(&ranges);
+	ranges_add(&ranges, 0x1000, 0x5000);
+	ranges_sub(&ranges, 0x2000, 0x3000);
+
+	Collected c = collect_all(&ranges);
+	CHECK_EQ(c.count, 2);
+	CHECK_EQ(c.start[0], 0x1000);
+	CHECK_EQ(c.end[0], 0x2000);
+	CHECK_EQ(c.start[1], 0x3000);
+	CHECK_EQ(c.end[1], 0x5000);
+
+	// Trimming the ends, and subtracting from nothing.
+	ranges_sub(&ranges, 0x0, 0x1800);
+	ranges_sub(&ranges, 0x4000, 0x9000);
+	ranges_sub(&ranges, 0xa000, 0xb000);
+	c = collect_all(&ranges);
+	CHECK_EQ(c.count, 2);
+	CHECK_EQ(c.start[0], 0x1800);
+	CHECK_EQ(c.end[0], 0x2000);
+	CHECK_EQ(c.start[1], 0x3000);
+	CHECK_EQ(c.end[1], 0x4000);
+
+	ranges_sub(&ranges, 0x1000, 0x5000);
+	CHECK_EQ(collect_all(&ranges).count, 0);
+	ranges_teardown(&ranges);
+}
+
+static void test_high_addresses(void)
+{
+	Ranges ranges;
+
+	ranges_init(&ranges);
+	ranges_add(&ranges, 0x100000000ULL, 0x180000000ULL);
+	ranges_add(&ranges, 0, 0x80000000);
+	ranges_sub(&ranges, 0x140000000ULL, 0x140001000ULL);
+
+	Collected c = collect_all(&ranges);
+	CHECK_EQ(c.count, 3);
+	CHECK_EQ(c.start[0], 0);
+	CHECK_EQ(c.end[1], 0x140000000ULL);
+	CHECK_EQ(c.start[2], 0x140001000ULL);
+	CHECK_EQ(c.end[2], 0x180000000ULL);
+	ranges_teardown(&ranges);
+}
+
+HostTest host_tests[] = {
+	{ "empty", &test_empty },
+	{ "add_disjoint", &test_add_disjoint },
+	{ "add_merges", &test_add_merges },
+	{ "sub_splits", &test_sub_splits },
+	{ "high_addresses", &test_high_addresses },
+	{ NULL }
+};
+
+uint64_t arch_phys_memset(uint64_t s, int c, uint64_t n)
+{
+	return s;
+}
+
+static void count_ranges(uint64_t start, uint64_t end, void *data)
+{
+	(*(uint64_t *)data)++;
+}
+
+/* Something like a fragmented memory map, then carving holes out of it. */
+static void bench_add_sub(uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; i++) {
+		Ranges ranges;
+		uint64_t count = 0;
+
+		ranges_init(&ranges);
+		for (int j = 0; j < BenchRanges; j++) {
+			uint64_t start = (uint64_t)j * 3 * MiB;
+			ranges_add(&ranges, start, start + 2 * MiB);
+		}
+		for (int j = 0; j < BenchRanges; j++) {
+			uint64_t start = (uint64_t)j * 3 * MiB + 64 * KiB;
+			ranges_sub(&ranges, start, start + 4 * KiB);
+		}
+		ranges_for_each(&ranges, &count_ranges, &count);
+		ranges_teardown(&ranges);
+		host_bench_sink = count;
+	}
+}
+
+HostBench host_benches[] = {
+	{ "add_sub_256", &bench_add_sub },
+	{ NULL }
+};
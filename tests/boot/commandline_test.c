@@ -0,0 +1,158 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "boot/commandline.h"
+#include "harness.h"
+
+static const char *board_options;
+
+// Overrides the weak default, so tests can pick what the board adds.
+const char *mainboard_commandline(void)
+{
+	return board_options;
+}
+
+static uint8_t guid[16] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+static const char guid_str[] = "33221100-5544-7766-8899-aabbccddeeff";
+
+static struct commandline_info info = {
+	.devnum = 1,
+	.partnum = 3,
+	.guid = guid,
+	.external_gpt = 0
+};
+
+static void test_plain(void)
+{
+	char dest[64];
+
+	board_options = NULL;
+	CHECK_EQ(commandline_subst("quiet loglevel=7", dest, sizeof(dest),
+				   &info), 0);
+	CHECK_STR_EQ(dest, "cros_secure quiet loglevel=7");
+
+	board_options = "console=ttyS0 ";
+	CHECK_EQ(commandline_subst("quiet", dest, sizeof(dest), &info), 0);
+	CHECK_STR_EQ(dest, "cros_secure console=ttyS0 quiet");
+	board_options = NULL;
+}
+
+static void test_device_and_partition(void)
+{
+	char dest[64];
+
+	// %D is a letter, unless a partition number follows.
+	CHECK_EQ(commandline_subst("root=/dev/sd%D%P", dest, sizeof(dest),
+				   &info), 0);
+	CHECK_STR_EQ(dest, "cros_secure root=/dev/sdb3");
+	CHECK_EQ(commandline_subst("root=/dev/mmcblk%Dp%P", dest,
+				   sizeof(dest), &info), 0);
+	CHECK_STR_EQ(dest, "cros_secure root=/dev/mmcblk1p3");
+
+	struct commandline_info bad = info;
+	bad.devnum = 26;
+	CHECK_EQ(commandline_subst("%D", dest, sizeof(dest), &bad), 1);
+	bad = info;
+	bad.partnum = 0;
+	CHECK_EQ(commandline_subst("%P", dest, sizeof(dest), &bad), 1);
+}
+
+static void test_guid_and_root(void)
+{
+	char dest[128];
+	char expected[128];
+
+	CHECK_EQ(commandline_subst("kern_guid=%U", dest, sizeof(dest),
+				   &info), 0);
+	snprintf(expected, sizeof(expected), "cros_secure kern_guid=%s",
+		 guid_str);
+	CHECK_STR_EQ(dest, expected);
+
+	CHECK_EQ(commandline_subst("root=%R", dest, sizeof(dest), &info), 0);
+	snprintf(expected, sizeof(expected),
+		 "cros_secure root=PARTUUID=%s/PARTNROFF=1", guid_str);
+	CHECK_STR_EQ(dest, expected);
+
+	struct commandline_info nand = info;
+	nand.external_gpt = 1;
+	CHECK_EQ(commandline_subst("root=%R", dest, sizeof(dest), &nand), 0);
+	CHECK_STR_EQ(dest, "cros_secure root=/dev/ubiblock3_0");
+}
+
+static void test_escapes(void)
+{
+	char dest[64];
+
+	// Unknown escapes are copied through.
+	CHECK_EQ(commandline_subst("a%%b%xc", dest, sizeof(dest), &info), 0);
+	CHECK_STR_EQ(dest, "cros_secure a%%b%xc");
+	CHECK_EQ(commandline_subst("trailing%", dest, sizeof(dest), &info),
+		 1);
+}
+
+static void test_out_of_space(void)
+{
+	char dest[128];
+
+	// There has to be room for the terminator after the prefix too.
+	CHECK_EQ(commandline_subst("", dest, sizeof("cros_secure ") - 1,
+				   &info), 1);
+	CHECK_EQ(commandline_subst("", dest, sizeof("cros_secure "), &info),
+		 0);
+	CHECK_STR_EQ(dest, "cros_secure ");
+	CHECK_EQ(commandline_subst("%U", dest, 12 + 36, &info), 1);
+	CHECK_EQ(commandline_subst("%U", dest, 12 + 37, &info), 0);
+	CHECK_EQ(commandline_subst("x", dest, 20000, &info), 1);
+}
+
+HostTest host_tests[] = {
+	{ "plain", &test_plain },
+	{ "device_and_partition", &test_device_and_partition },
+	{ "guid_and_root", &test_guid_and_root },
+	{ "escapes", &test_escapes },
+	{ "out_of_space", &test_out_of_space },
+	{ NULL }
+};
+
+// A typical Chrome OS kernel command line, before substitution.
+static const char bench_cmdline[] =
+	"console= loglevel=7 init=/sbin/init cros_secure oops=panic panic=-1 "
+	"root=/dev/dm-0 rootwait ro dm_verity.error_behavior=3 "
+	"dm_verity.max_bios=-1 dm_verity.dev_wait=1 dm=\"1 vroot none ro 1,"
+	"0 2506752 verity payload=PARTUUID=%U/PARTNROFF=1 "
+	"hashtree=PARTUUID=%U/PARTNROFF=1 hashstart=2506752 alg=sha1 "
+	"root_hexdigest=0123456789abcdef0123456789abcdef01234567 "
+	"salt=0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\" "
+	"noinitrd vt.global_cursor_default=0 kern_guid=%U "
+	"add_efi_memmap boot=local noresume noswap i915.modeset=1 "
+	"tpm_tis.force=1 tpm_tis.interrupts=0 nmi_watchdog=panic,lapic";
+
+static void bench_subst(uint64_t iterations)
+{
+	static char dest[4096];
+
+	for (uint64_t i = 0; i < iterations; i++)
+		host_bench_sink = commandline_subst(bench_cmdline, dest,
+						    sizeof(dest), &info);
+}
+
+HostBench host_benches[] = {
+	{ "subst_typical", &bench_subst, sizeof(bench_cmdline) - 1 },
+	{ NULL }
+};
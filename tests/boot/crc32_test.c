@@ -0,0 +1,112 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "boot/crc32.h"
+#include "harness.h"
+
+enum {
+	BenchSmall = 4 * KiB,
+	BenchLarge = 1 * MiB
+};
+
+// The slow, obviously right way.
+static uint32_t reference_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+static void fill_pattern(uint8_t *buf, size_t len)
+{
+	uint32_t x = 0x12345678;
+
+	for (size_t i = 0; i < len; i++) {
+		x = x * 1103515245 + 12345;
+		buf[i] = x >> 16;
+	}
+}
+
+static void test_check_value(void)
+{
+	CHECK_EQ(crc32(0, "123456789", 9), 0xcbf43926);
+	CHECK_EQ(crc32(0, "", 0), 0);
+	CHECK_EQ(crc32(0, "a", 1), 0xe8b7be43);
+}
+
+static void test_incremental(void)
+{
+	static const char msg[] = "The quick brown fox jumps over the lazy dog";
+	const unsigned len = sizeof(msg) - 1;
+
+	CHECK_EQ(crc32(0, msg, len), 0x414fa339);
+	for (unsigned split = 0; split <= len; split++) {
+		uint32_t crc = crc32(0, msg, split);
+		CHECK_EQ(crc32(crc, msg + split, len - split), 0x414fa339);
+	}
+}
+
+static void test_alignment(void)
+{
+	uint8_t buf[256 + 8];
+
+	fill_pattern(buf, sizeof(buf));
+	// Every start alignment with lengths around the word size.
+	for (int offset = 0; offset < 8; offset++) {
+		for (unsigned len = 0; len <= 256; len += (len < 16 ? 1 : 61))
+			CHECK_EQ(crc32(0, buf + offset, len),
+				 reference_crc32(0, buf + offset, len));
+	}
+}
+
+HostTest host_tests[] = {
+	{ "check_value", &test_check_value },
+	{ "incremental", &test_incremental },
+	{ "alignment", &test_alignment },
+	{ NULL }
+};
+
+static uint8_t bench_buf[BenchLarge];
+
+static void bench_crc32(uint64_t iterations, unsigned len)
+{
+	fill_pattern(bench_buf, len);
+
+	host_bench_start();
+	uint32_t crc = 0;
+	for (uint64_t i = 0; i < iterations; i++)
+		crc = crc32(crc, bench_buf, len);
+	host_bench_sink = crc;
+}
+
+static void bench_crc32_small(uint64_t iterations)
+{
+	bench_crc32(iterations, BenchSmall);
+}
+
+static void bench_crc32_large(uint64_t iterations)
+{
+	bench_crc32(iterations, BenchLarge);
+}
+
+HostBench host_benches[] = {
+	{ "crc32_4k", &bench_crc32_small, BenchSmall },
+	{ "crc32_1m", &bench_crc32_large, BenchLarge },
+	{ NULL }
+};
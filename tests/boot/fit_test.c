@@ -0,0 +1,308 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "boot/fit.h"
+#include "harness.h"
+#include "tree.h"
+
+enum {
+	KernelSize = 64 * KiB,
+	BenchConfigs = 32
+};
+
+static uint8_t kernel[KernelSize];
+static uint8_t ramdisk[4 * KiB];
+
+// A kernel device tree whose root is compatible with compat.
+static void *kernel_fdt(const char *compat, uint32_t *size)
+{
+	DeviceTree *tree = test_tree_new();
+
+	dt_add_u32_prop(tree->root, "#address-cells", 2);
+	dt_add_u32_prop(tree->root, "#size-cells", 2);
+	dt_add_bin_prop(tree->root, "compatible", (void *)compat,
+			strlen(compat) + 1);
+	dt_find_node_by_path(tree->root, "chosen", NULL, NULL, 1);
+	return test_tree_flatten(tree, size);
+}
+
+static DeviceTreeNode *fit_node(DeviceTree *fit, const char *dir,
+				const char *name)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	return dt_find_node_by_path(fit->root, path, NULL, NULL, 1);
+}
+
+static void fit_add_image(DeviceTree *fit, const char *name, void *data,
+			  uint32_t size)
+{
+	DeviceTreeNode *node = fit_node(fit, "images", name);
+
+	dt_add_bin_prop(node, "data", data, size);
+	dt_add_string_prop(node, "compression", "none");
+}
+
+static void fit_add_config(DeviceTree *fit, const char *name,
+			   const char *kernel_name, const char *fdt_name,
+			   const char *ramdisk_name)
+{
+	DeviceTreeNode *node = fit_node(fit, "configurations", name);
+
+	dt_add_string_prop(node, "kernel", (char *)kernel_name);
+	if (fdt_name)
+		dt_add_string_prop(node, "fdt", (char *)fdt_name);
+	if (ramdisk_name)
+		dt_add_string_prop(node, "ramdisk", (char *)ramdisk_name);
+}
+
+static void fit_set_default(DeviceTree *fit, const char *name)
+{
+	DeviceTreeNode *node = dt_find_node_by_path(fit->root,
+						    "configurations",
+						    NULL, NULL, 1);
+	dt_add_string_prop(node, "default", (char *)name);
+}
+
+/*
+ * A FIT with one kernel and a config for each of two device trees, where
+ * conf@1 is the default.
+ */
+static void *two_config_fit(const char *compat1, const char *compat2)
+{
+	DeviceTree *fit = test_tree_new();
+	uint32_t size;
+	void *fdt;
+
+	fit_add_image(fit, "kernel@1", kernel, sizeof(kernel));
+	fdt = kernel_fdt(compat1, &size);
+	fit_add_image(fit, "fdt@1", fdt, size);
+	fdt = kernel_fdt(compat2, &size);
+	fit_add_image(fit, "fdt@2", fdt, size);
+	fit_add_config(fit, "conf@1", "kernel@1", "fdt@1", NULL);
+	fit_add_config(fit, "conf@2", "kernel@1", "fdt@2", NULL);
+	fit_set_default(fit, "conf@1");
+	return test_tree_flatten(fit, NULL);
+}
+
+static const char *root_compat(DeviceTree *dt)
+{
+	return dt_find_string_prop(dt->root, "compatible");
+}
+
+static void set_memory(void)
+{
+	static const struct memrange ranges[] = {
+		{ 0x80000000, 0x40000000, CB_MEM_RAM },
+		{ 0xc0000000, 0x100000, CB_MEM_TABLE },
+		// Not a whole number of MiB.
+		{ 0x100000000ULL, 0x80000800, CB_MEM_RAM },
+	};
+
+	memcpy(lib_sysinfo.memrange, ranges, sizeof(ranges));
+	lib_sysinfo.n_memranges = ARRAY_SIZE(ranges);
+}
+
+/* This has to run first, before anything calls fit_set_compat(). */
+static void test_default_compat(void)
+{
+	void *fit = two_config_fit("google,other", "google,host-rev3");
+	DeviceTree *dt = NULL;
+
+	lib_sysinfo.board_id = 3;
+	set_memory();
+	FitImageNode *image = fit_load(fit, NULL, &dt);
+	CHECK(image);
+	CHECK(dt);
+	CHECK_STR_EQ(root_compat(dt), "google,host-rev3");
+}
+
+static void test_compat_beats_default(void)
+{
+	for (int i = 0; i < sizeof(kernel); i++)
+		kernel[i] = i * 13;
+
+	void *fit = two_config_fit("google,a", "google,b");
+	DeviceTree *dt = NULL;
+
+	fit_set_compat("google,b");
+	FitImageNode *image = fit_load(fit, NULL, &dt);
+	CHECK(image);
+	CHECK_STR_EQ(image->name, "kernel@1");
+	CHECK(!memcmp(image->data, kernel, sizeof(kernel)));
+	CHECK_EQ(image->size, sizeof(kernel));
+	CHECK_STR_EQ(root_compat(dt), "google,b");
+}
+
+static void test_falls_back_to_default(void)
+{
+	void *fit = two_config_fit("google,a", "google,b");
+	DeviceTree *dt = NULL;
+
+	fit_set_compat("google,c");
+	CHECK(fit_load(fit, NULL, &dt));
+	CHECK_STR_EQ(root_compat(dt), "google,a");
+
+	// With no default either, there's nothing to boot.
+	DeviceTree *tree = test_tree_new();
+	uint32_t size;
+	void *fdt;
+	fit_add_image(tree, "kernel@1", kernel, sizeof(kernel));
+	fdt = kernel_fdt("google,a", &size);
+	fit_add_image(tree, "fdt@1", fdt, size);
+	fit_add_config(tree, "conf@1", "kernel@1", "fdt@1", NULL);
+	CHECK(!fit_load(test_tree_flatten(tree, NULL), NULL, &dt));
+}
+
+static void test_missing_image(void)
+{
+	DeviceTree *tree = test_tree_new();
+	DeviceTree *dt = NULL;
+	uint32_t size;
+	void *fdt;
+
+	fit_add_image(tree, "kernel@1", kernel, sizeof(kernel));
+	fdt = kernel_fdt("google,a", &size);
+	fit_add_image(tree, "fdt@1", fdt, size);
+	// The best match refers to a kernel which isn't there.
+	fit_add_config(tree, "conf@1", "kernel@1", "fdt@1", NULL);
+	fit_add_config(tree, "conf@2", "kernel@2", "fdt@1", NULL);
+	fit_set_default(tree, "conf@2");
+
+	fit_set_compat("google,a");
+	CHECK(fit_load(test_tree_flatten(tree, NULL), NULL, &dt));
+	CHECK_STR_EQ(root_compat(dt), "google,a");
+}
+
+static void test_bad_magic(void)
+{
+	uint8_t *fit = two_config_fit("google,a", "google,b");
+	DeviceTree *dt = NULL;
+
+	fit[0] ^= 0xff;
+	CHECK(!fit_load(fit, NULL, &dt));
+}
+
+static void test_kernel_dt_updates(void)
+{
+	DeviceTree *tree = test_tree_new();
+	DeviceTree *dt = NULL;
+	uint32_t size;
+	void *fdt;
+	static char cmd_line[] = "console=ttyS0 quiet";
+
+	fit_add_image(tree, "kernel@1", kernel, sizeof(kernel));
+	fdt = kernel_fdt("google,a", &size);
+	fit_add_image(tree, "fdt@1", fdt, size);
+	fit_add_image(tree, "ramdisk@1", ramdisk, sizeof(ramdisk));
+	fit_add_config(tree, "conf@1", "kernel@1", "fdt@1", "ramdisk@1");
+
+	set_memory();
+	fit_set_compat("google,a");
+	CHECK(fit_load(test_tree_flatten(tree, NULL), cmd_line, &dt));
+
+	DeviceTreeNode *chosen = dt_find_node_by_path(dt->root, "chosen",
+						      NULL, NULL, 0);
+	CHECK(chosen);
+	CHECK_STR_EQ(dt_find_string_prop(chosen, "bootargs"), cmd_line);
+
+	void *start, *end;
+	size_t start_size, end_size;
+	dt_find_bin_prop(chosen, "linux,initrd-start", &start, &start_size);
+	dt_find_bin_prop(chosen, "linux,initrd-end", &end, &end_size);
+	CHECK_EQ(start_size, sizeof(uint32_t));
+	CHECK_EQ(end_size, sizeof(uint32_t));
+	CHECK_EQ(betohl(*(uint32_t *)end) - betohl(*(uint32_t *)start),
+		 sizeof(ramdisk));
+
+	// RAM is trimmed to whole MiB, and the rest is reserved.
+	DeviceTreeNode *memory = dt_find_node_by_path(dt->root, "memory",
+						      NULL, NULL, 0);
+	CHECK(memory);
+	CHECK_STR_EQ(dt_find_string_prop(memory, "device_type"), "memory");
+	void *reg;
+	size_t reg_size;
+	dt_find_bin_prop(memory, "reg", &reg, &reg_size);
+	CHECK_EQ(reg_size, 2 * 4 * sizeof(uint32_t));
+	uint64_t *cells = reg;
+	CHECK_EQ(betohll(cells[0]), 0x80000000);
+	CHECK_EQ(betohll(cells[1]), 0x40000000);
+	CHECK_EQ(betohll(cells[2]), 0x100000000ULL);
+	CHECK_EQ(betohll(cells[3]), 0x80000000);
+
+	DeviceTreeReserveMapEntry *entry;
+	int reserved = 0;
+	list_for_each(entry, dt->reserve_map, list_node) {
+		if (entry->start == 0xc0000000)
+			CHECK_EQ(entry->size, 0x100000);
+		else if (entry->start == 0x180000000ULL)
+			CHECK_EQ(entry->size, 0x800);
+		else
+			CHECK(0);
+		reserved++;
+	}
+	CHECK_EQ(reserved, 2);
+}
+
+HostTest host_tests[] = {
+	{ "default_compat", &test_default_compat },
+	{ "compat_beats_default", &test_compat_beats_default },
+	{ "falls_back_to_default", &test_falls_back_to_default },
+	{ "missing_image", &test_missing_image },
+	{ "bad_magic", &test_bad_magic },
+	{ "kernel_dt_updates", &test_kernel_dt_updates },
+	{ NULL }
+};
+
+/* A kernel built for many boards, where only one board matches. */
+static void bench_load(uint64_t iterations)
+{
+	DeviceTree *tree = test_tree_new();
+	static char cmd_line[] = "console=ttyS0 root=/dev/dm-0 rootwait ro";
+
+	fit_add_image(tree, "kernel@1", kernel, sizeof(kernel));
+	for (int i = 0; i < BenchConfigs; i++) {
+		char fdt_name[32], conf_name[32], compat[32];
+		uint32_t size;
+
+		snprintf(compat, sizeof(compat), "google,board%d-rev0", i);
+		snprintf(fdt_name, sizeof(fdt_name), "fdt@%d", i);
+		snprintf(conf_name, sizeof(conf_name), "conf@%d", i);
+		void *fdt = kernel_fdt(compat, &size);
+		fit_add_image(tree, fdt_name, fdt, size);
+		// Property values have to last until the FIT is flattened.
+		fit_add_config(tree, conf_name, "kernel@1", strdup(fdt_name),
+			       NULL);
+	}
+	void *fit = test_tree_flatten(tree, NULL);
+
+	set_memory();
+	fit_set_compat("google,board0-rev0");
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++) {
+		DeviceTree *dt;
+
+		host_alloc_track();
+		host_bench_sink = (uintptr_t)fit_load(fit, cmd_line, &dt);
+		host_alloc_free_tracked();
+	}
+}
+
+HostBench host_benches[] = {
+	{ "load_32_configs", &bench_load },
+	{ NULL }
+};
@@ -0,0 +1,361 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "fastboot/sparse.h"
+#include "harness.h"
+
+enum {
+	DiskBlockSize = 512,
+	DiskBlocks = 64,
+	ImageBlockSize = 4096,
+	BenchChunks = 1024,
+	BenchChunkBlocks = 4
+};
+
+/* A block device backed by memory. */
+typedef struct {
+	BlockDevOps ops;
+	uint8_t *data;
+	lba_t blocks;
+	int writes;
+} RamDisk;
+
+static lba_t ram_write(BlockDevOps *me, lba_t start, lba_t count,
+		       const void *buffer)
+{
+	RamDisk *disk = container_of(me, RamDisk, ops);
+
+	if (start + count > disk->blocks)
+		return 0;
+	memcpy(disk->data + start * DiskBlockSize, buffer,
+	       count * DiskBlockSize);
+	disk->writes++;
+	return count;
+}
+
+static lba_t ram_fill_write(BlockDevOps *me, lba_t start, lba_t count,
+			    uint8_t fill_byte)
+{
+	RamDisk *disk = container_of(me, RamDisk, ops);
+
+	if (start + count > disk->blocks)
+		return 0;
+	memset(disk->data + start * DiskBlockSize, fill_byte,
+	       count * DiskBlockSize);
+	disk->writes++;
+	return count;
+}
+
+static void ram_disk_init(RamDisk *disk, lba_t blocks)
+{
+	memset(disk, 0, sizeof(*disk));
+	disk->ops.write = &ram_write;
+	disk->ops.fill_write = &ram_fill_write;
+	disk->blocks = blocks;
+	disk->data = xmalloc(blocks * DiskBlockSize);
+	memset(disk->data, 0xee, blocks * DiskBlockSize);
+}
+
+/* Builds a sparse image one chunk at a time. */
+typedef struct {
+	uint8_t *buf;
+	size_t size;
+	size_t capacity;
+} Image;
+
+static void image_append(Image *image, const void *data, size_t size)
+{
+	if (image->size + size > image->capacity) {
+		image->capacity = MAX(image->capacity * 2,
+				      image->size + size);
+		image->buf = realloc(image->buf, image->capacity);
+	}
+	memcpy(image->buf + image->size, data, size);
+	image->size += size;
+}
+
+static uint32_t *image_header_field(Image *image, int word)
+{
+	return (uint32_t *)image->buf + word;
+}
+
+static void image_start(Image *image)
+{
+	memset(image, 0, sizeof(*image));
+
+	uint32_t magic = 0xed26ff3a;
+	uint16_t version[2] = { 1, 0 };
+	uint16_t sizes[2] = { 28, 12 };
+	uint32_t rest[4] = { ImageBlockSize, 0, 0, 0 };
+	image_append(image, &magic, sizeof(magic));
+	image_append(image, version, sizeof(version));
+	image_append(image, sizes, sizeof(sizes));
+	image_append(image, rest, sizeof(rest));
+}
+
+static void image_chunk(Image *image, uint16_t type, uint32_t blocks,
+			const void *data, uint32_t data_size)
+{
+	uint16_t type_fields[2] = { type, 0 };
+	uint32_t size_fields[2] = { blocks, 12 + data_size };
+
+	image_append(image, type_fields, sizeof(type_fields));
+	image_append(image, size_fields, sizeof(size_fields));
+	if (data_size)
+		image_append(image, data, data_size);
+
+	// Total blocks, then total chunks.
+	*image_header_field(image, 4) += blocks;
+	*image_header_field(image, 5) += 1;
+}
+
+static int disk_holds(RamDisk *disk, lba_t start, size_t size,
+		      const void *expected)
+{
+	return !memcmp(disk->data + start * DiskBlockSize, expected, size);
+}
+
+static int disk_filled(RamDisk *disk, lba_t start, size_t size, uint8_t byte)
+{
+	for (size_t i = 0; i < size; i++)
+		if (disk->data[start * DiskBlockSize + i] != byte)
+			return 0;
+	return 1;
+}
+
+static void test_detect(void)
+{
+	Image image;
+
+	image_start(&image);
+	CHECK(is_sparse_image(image.buf));
+	image.buf[4] = 2;
+	CHECK(!is_sparse_image(image.buf));
+	image.buf[4] = 1;
+	image.buf[0] ^= 1;
+	CHECK(!is_sparse_image(image.buf));
+	free(image.buf);
+}
+
+static void test_all_chunk_types(void)
+{
+	RamDisk disk;
+	Image image;
+	uint8_t raw[ImageBlockSize * 2];
+	uint32_t zero = 0, pattern = 0xa5a5a5a5, crc = 0x12345678;
+
+	for (int i = 0; i < sizeof(raw); i++)
+		raw[i] = i * 7;
+
+	ram_disk_init(&disk, DiskBlocks);
+	image_start(&image);
+	image_chunk(&image, 0xcac1, 2, raw, sizeof(raw));
+	image_chunk(&image, 0xcac3, 1, NULL, 0);
+	image_chunk(&image, 0xcac2, 1, &zero, sizeof(zero));
+	image_chunk(&image, 0xcac2, 1, &pattern, sizeof(pattern));
+	image_chunk(&image, 0xcac4, 0, &crc, sizeof(crc));
+
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 8, 48,
+				    image.buf, image.size), BE_SUCCESS);
+
+	const lba_t per_block = ImageBlockSize / DiskBlockSize;
+	CHECK(disk_filled(&disk, 0, 8 * DiskBlockSize, 0xee));
+	CHECK(disk_holds(&disk, 8, sizeof(raw), raw));
+	// Don't care chunks leave what was there.
+	CHECK(disk_filled(&disk, 8 + 2 * per_block, ImageBlockSize, 0xee));
+	CHECK(disk_filled(&disk, 8 + 3 * per_block, ImageBlockSize, 0));
+	CHECK(disk_filled(&disk, 8 + 4 * per_block, ImageBlockSize, 0xa5));
+	CHECK(disk_filled(&disk, 8 + 5 * per_block,
+			  (DiskBlocks - 8 - 5 * per_block) * DiskBlockSize,
+			  0xee));
+
+	free(image.buf);
+	free(disk.data);
+}
+
+static void test_fill_pattern(void)
+{
+	RamDisk disk;
+	Image image;
+	uint32_t pattern = 0x04030201;
+
+	ram_disk_init(&disk, DiskBlocks);
+	image_start(&image);
+	image_chunk(&image, 0xcac2, 3, &pattern, sizeof(pattern));
+
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_SUCCESS);
+
+	// The whole word repeats, not just one byte of it.
+	for (int i = 0; i < 3 * ImageBlockSize; i += sizeof(pattern))
+		CHECK(!memcmp(disk.data + i, &pattern, sizeof(pattern)));
+	CHECK(disk_filled(&disk, 3 * ImageBlockSize / DiskBlockSize,
+			  DiskBlockSize, 0xee));
+
+	free(image.buf);
+	free(disk.data);
+}
+
+static void test_overflow(void)
+{
+	RamDisk disk;
+	Image image;
+	uint32_t zero = 0;
+
+	ram_disk_init(&disk, DiskBlocks);
+	image_start(&image);
+	image_chunk(&image, 0xcac2, 2, &zero, sizeof(zero));
+
+	// Two image blocks are 16 disk blocks.
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, 15,
+				    image.buf, image.size),
+		 BE_IMAGE_OVERFLOW_ERR);
+	CHECK_EQ(disk.writes, 0);
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, 16,
+				    image.buf, image.size), BE_SUCCESS);
+
+	free(image.buf);
+	free(disk.data);
+}
+
+static void test_bad_headers(void)
+{
+	RamDisk disk;
+	Image image;
+	uint32_t zero = 0;
+
+	ram_disk_init(&disk, DiskBlocks);
+	image_start(&image);
+	image_chunk(&image, 0xcac2, 1, &zero, sizeof(zero));
+
+	// File header size.
+	image.buf[8] = 32;
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_SPARSE_HDR_ERR);
+	image.buf[8] = 28;
+
+	// Image blocks must be whole disk blocks.
+	CHECK_EQ(write_sparse_image(&disk.ops, 8192, 0, DiskBlocks,
+				    image.buf, image.size),
+		 BE_IMAGE_SIZE_MULTIPLE_ERR);
+
+	// Chunk header size.
+	image.buf[10] = 16;
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_CHUNK_HDR_ERR);
+	image.buf[10] = 12;
+
+	// Unknown chunk type.
+	image.buf[28] = 0xc5;
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_CHUNK_HDR_ERR);
+	image.buf[28] = 0xc2;
+
+	// A fill chunk's data is exactly four bytes.
+	image.buf[28 + 8] = 20;
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_CHUNK_HDR_ERR);
+	image.buf[28 + 8] = 16;
+
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_SUCCESS);
+
+	free(image.buf);
+	free(disk.data);
+}
+
+static void test_truncated(void)
+{
+	RamDisk disk;
+	Image image;
+	uint8_t raw[ImageBlockSize];
+
+	memset(raw, 0x5a, sizeof(raw));
+	ram_disk_init(&disk, DiskBlocks);
+	image_start(&image);
+	image_chunk(&image, 0xcac1, 1, raw, sizeof(raw));
+
+	// Nothing past the end of the image is read.
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size - 1),
+		 BE_CHUNK_HDR_ERR);
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, 28 + 6), BE_CHUNK_HDR_ERR);
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, 20), BE_SPARSE_HDR_ERR);
+	CHECK_EQ(disk.writes, 0);
+
+	// More chunks promised than are there.
+	*image_header_field(&image, 5) = 2;
+	CHECK_EQ(write_sparse_image(&disk.ops, DiskBlockSize, 0, DiskBlocks,
+				    image.buf, image.size), BE_CHUNK_HDR_ERR);
+
+	free(image.buf);
+	free(disk.data);
+}
+
+HostTest host_tests[] = {
+	{ "detect", &test_detect },
+	{ "all_chunk_types", &test_all_chunk_types },
+	{ "fill_pattern", &test_fill_pattern },
+	{ "overflow", &test_overflow },
+	{ "bad_headers", &test_bad_headers },
+	{ "truncated", &test_truncated },
+	{ NULL }
+};
+
+/* Like a filesystem image: data, zeroed space and holes, over and over. */
+static void bench_write(uint64_t iterations)
+{
+	static uint8_t raw[BenchChunkBlocks * ImageBlockSize];
+	const lba_t disk_blocks = (uint64_t)BenchChunks * BenchChunkBlocks *
+				  ImageBlockSize / DiskBlockSize;
+	uint32_t zero = 0;
+	RamDisk disk;
+	Image image;
+
+	ram_disk_init(&disk, disk_blocks);
+	image_start(&image);
+	for (int i = 0; i < BenchChunks; i++) {
+		switch (i % 3) {
+		case 0:
+			image_chunk(&image, 0xcac1, BenchChunkBlocks, raw,
+				    sizeof(raw));
+			break;
+		case 1:
+			image_chunk(&image, 0xcac2, BenchChunkBlocks, &zero,
+				    sizeof(zero));
+			break;
+		case 2:
+			image_chunk(&image, 0xcac3, BenchChunkBlocks, NULL, 0);
+			break;
+		}
+	}
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++)
+		host_bench_sink = write_sparse_image(&disk.ops, DiskBlockSize,
+						     0, disk_blocks, image.buf,
+						     image.size);
+
+	free(image.buf);
+	free(disk.data);
+}
+
+HostBench host_benches[] = {
+	{ "write_4m", &bench_write,
+	  (uint64_t)BenchChunks * BenchChunkBlocks * ImageBlockSize },
+	{ NULL }
+};
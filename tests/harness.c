@@ -0,0 +1,230 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "base/timestamp.h"
+#include "harness.h"
+
+/*
+ * The runner for the host test programs, and the parts of libpayload and
+ * depthcharge the shim needs real definitions for.
+ *
+ *   <program> [-v]                 run every test
+ *   <program> [-v] --bench [name]  run the benchmarks, or those starting
+ *                                  with name
+ *
+ * What the code under test prints is thrown away unless -v is given.
+ */
+
+enum {
+	// Keep doubling the iterations until a run takes at least this long.
+	BenchMinNs = 200 * 1000 * 1000,
+	BenchMaxIterations = 1 << 30
+};
+
+struct sysinfo_t lib_sysinfo;
+
+volatile uint64_t host_bench_sink;
+
+// Where the harness reports to, which stays stdout even when it's silenced.
+static FILE *out;
+
+static int failed;
+static uint64_t bench_start_ns;
+
+static int tracking;
+static void **tracked;
+static size_t num_tracked;
+static size_t max_tracked;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void *xmalloc(size_t size)
+{
+	void *ptr = malloc(size);
+
+	if (!ptr && size) {
+		fprintf(stderr, "Out of memory allocating %zu bytes.\n", size);
+		abort();
+	}
+
+	if (tracking) {
+		if (num_tracked == max_tracked) {
+			max_tracked = max_tracked ? max_tracked * 2 : 1024;
+			tracked = realloc(tracked,
+					  max_tracked * sizeof(*tracked));
+			if (!tracked)
+				abort();
+		}
+		tracked[num_tracked++] = ptr;
+	}
+	return ptr;
+}
+
+void *xzalloc(size_t size)
+{
+	void *ptr = xmalloc(size);
+
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+void host_alloc_track(void)
+{
+	tracking = 1;
+}
+
+void host_alloc_free_tracked(void)
+{
+	for (size_t i = 0; i < num_tracked; i++)
+		free(tracked[i]);
+	num_tracked = 0;
+	tracking = 0;
+}
+
+uint64_t timer_hz(void)
+{
+	return 1000000000;
+}
+
+uint64_t timer_raw_value(void)
+{
+	return now_ns();
+}
+
+uint64_t timer_us(uint64_t base)
+{
+	return now_ns() / 1000 - base;
+}
+
+void timestamp_add_now(enum timestamp_id id)
+{
+}
+
+void host_test_fail(const char *file, int line, const char *cond)
+{
+	fprintf(out, "%s:%d: check failed: %s\n", file, line, cond);
+	failed = 1;
+}
+
+void host_test_fail_eq(const char *file, int line, const char *expr,
+		       unsigned long long actual, unsigned long long expected)
+{
+	fprintf(out, "%s:%d: %s is %#llx, expected %#llx\n", file, line,
+		expr, actual, expected);
+	failed = 1;
+}
+
+void host_bench_start(void)
+{
+	bench_start_ns = now_ns();
+}
+
+static int run_tests(const char *program)
+{
+	int failures = 0;
+	int count = 0;
+
+	for (HostTest *test = host_tests; test->name; test++) {
+		failed = 0;
+		test->run();
+		count++;
+		if (failed) {
+			fprintf(out, "FAIL %s: %s\n", program, test->name);
+			failures++;
+		}
+	}
+
+	fprintf(out, "%s: %d of %d tests passed.\n", program,
+		count - failures, count);
+	return failures ? 1 : 0;
+}
+
+static void run_bench(const char *program, HostBench *bench)
+{
+	uint64_t iterations = 1;
+	uint64_t elapsed;
+
+	for (;;) {
+		bench_start_ns = now_ns();
+		bench->run(iterations);
+		elapsed = now_ns() - bench_start_ns;
+		if (elapsed >= BenchMinNs || iterations >= BenchMaxIterations)
+			break;
+		// Aim a little past the minimum so the next run is the last.
+		if (elapsed * 100 < BenchMinNs)
+			iterations *= 100;
+		else
+			iterations = iterations * BenchMinNs / elapsed * 6 / 5 + 1;
+	}
+
+	fprintf(out, "%-18s %-22s %10llu %14.1f ns/op", program, bench->name,
+		(unsigned long long)iterations, (double)elapsed / iterations);
+	if (bench->bytes)
+		fprintf(out, " %10.1f MiB/s", (double)bench->bytes *
+			iterations / MiB / ((double)elapsed / 1000000000));
+	fprintf(out, "\n");
+	fflush(out);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *program = strrchr(argv[0], '/');
+	program = program ? program + 1 : argv[0];
+
+	int verbose = 0;
+	int bench = 0;
+	const char *filter = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-v")) {
+			verbose = 1;
+		} else if (!strcmp(argv[i], "--bench")) {
+			bench = 1;
+		} else if (bench && !filter) {
+			filter = argv[i];
+		} else {
+			fprintf(stderr, "Usage: %s [-v] [--bench [name]]\n",
+				program);
+			return 1;
+		}
+	}
+
+	out = stdout;
+	if (!verbose) {
+		out = fdopen(dup(STDOUT_FILENO), "w");
+		if (!out || !freopen("/dev/null", "w", stdout)) {
+			perror(program);
+			return 1;
+		}
+	}
+
+	if (!bench)
+		return run_tests(program);
+
+	for (HostBench *b = host_benches; b->name; b++) {
+		if (filter && strncmp(b->name, filter, strlen(filter)))
+			continue;
+		run_bench(program, b);
+	}
+	return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TESTS_HARNESS_H__
+#define __TESTS_HARNESS_H__
+
+#include <stdint.h>
+
+/*
+ * Each test program is one module's sources built against the libpayload
+ * shim in tests/include, plus a file defining host_tests and host_benches,
+ * each ending with an entry with a NULL name.
+ */
+
+typedef struct {
+	const char *name;
+	void (*run)(void);
+} HostTest;
+
+typedef struct {
+	const char *name;
+	// Do whatever's being measured iterations times.
+	void (*run)(uint64_t iterations);
+	// Bytes handled per iteration, for a throughput figure, or 0.
+	uint64_t bytes;
+} HostBench;
+
+extern HostTest host_tests[];
+extern HostBench host_benches[];
+
+void host_test_fail(const char *file, int line, const char *cond);
+void host_test_fail_eq(const char *file, int line, const char *expr,
+		       unsigned long long actual, unsigned long long expected);
+
+// A failed check ends the test it's in, so only use them in test functions.
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		host_test_fail(__FILE__, __LINE__, #cond); \
+		return; \
+	} \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+	unsigned long long _actual = (actual); \
+	unsigned long long _expected = (expected); \
+	if (_actual != _expected) { \
+		host_test_fail_eq(__FILE__, __LINE__, #actual, _actual, \
+				  _expected); \
+		return; \
+	} \
+} while (0)
+
+#define CHECK_STR_EQ(actual, expected) CHECK(!strcmp((actual), (expected)))
+
+/*
+ * Restart the clock for the benchmark that's running, to leave its setup
+ * out of the measurement.
+ */
+void host_bench_start(void);
+
+/*
+ * Free everything xmalloc()ed or xzalloc()ed since host_alloc_track(), for
+ * benchmarking code which never frees what it allocates, like fdt_unflatten().
+ * Nothing allocated in between may be freed any other way.
+ */
+void host_alloc_track(void);
+void host_alloc_free_tracked(void);
+
+// Somewhere to put results so the work producing them isn't optimized out.
+extern volatile uint64_t host_bench_sink;
+
+#endif /* __TESTS_HARNESS_H__ */
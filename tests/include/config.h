@@ -0,0 +1,20 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TESTS_INCLUDE_CONFIG_H__
+#define __TESTS_INCLUDE_CONFIG_H__
+
+// Stands in for the Kconfig generated header; there's no .config here.
+#define CONFIG_BOARD "host"
+
+#endif /* __TESTS_INCLUDE_CONFIG_H__ */
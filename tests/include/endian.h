@@ -0,0 +1,34 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TESTS_INCLUDE_ENDIAN_H__
+#define __TESTS_INCLUDE_ENDIAN_H__
+
+// The host's own endian.h is used by its libc headers too.
+#include_next <endian.h>
+
+// libpayload's names for the same conversions.
+#define htobew(x) htobe16(x)
+#define htobel(x) htobe32(x)
+#define htobell(x) htobe64(x)
+#define htolew(x) htole16(x)
+#define htolel(x) htole32(x)
+#define htolell(x) htole64(x)
+#define betohw(x) be16toh(x)
+#define betohl(x) be32toh(x)
+#define betohll(x) be64toh(x)
+#define letohw(x) le16toh(x)
+#define letohl(x) le32toh(x)
+#define letohll(x) le64toh(x)
+
+#endif /* __TESTS_INCLUDE_ENDIAN_H__ */
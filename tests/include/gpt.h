@@ -0,0 +1,24 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TESTS_INCLUDE_GPT_H__
+#define __TESTS_INCLUDE_GPT_H__
+
+#include <stdint.h>
+
+// Only the types fastboot/backend.h refers to, vboot isn't built for the host.
+typedef struct {
+	uint8_t u[16];
+} Guid;
+
+#endif /* __TESTS_INCLUDE_GPT_H__ */
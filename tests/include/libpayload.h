@@ -0,0 +1,85 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TESTS_INCLUDE_LIBPAYLOAD_H__
+#define __TESTS_INCLUDE_LIBPAYLOAD_H__
+
+/*
+ * Just enough of libpayload, on top of the host's libc, to build the
+ * hardware independent parts of depthcharge for host tests and benchmarks.
+ * Add to it as more modules are brought over, but keep anything which would
+ * need real hardware out.
+ */
+
+#include <endian.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#define KiB (1 << 10)
+#define MiB (1 << 20)
+#define GiB (1 << 30)
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#define MIN(a, b) ({ __typeof__(a) _a = (a); __typeof__(b) _b = (b); \
+		     _a < _b ? _a : _b; })
+#define MAX(a, b) ({ __typeof__(a) _a = (a); __typeof__(b) _b = (b); \
+		     _a > _b ? _a : _b; })
+
+#define ALIGN(x, a) __ALIGN_MASK(x, (__typeof__(x))(a) - 1UL)
+#define __ALIGN_MASK(x, mask) (((x) + (mask)) & ~(mask))
+#define ALIGN_UP(x, a) ALIGN((x), (a))
+#define ALIGN_DOWN(x, a) ((x) & ~((__typeof__(x))(a) - 1UL))
+#define IS_ALIGNED(x, a) (((x) & ((__typeof__(x))(a) - 1UL)) == 0)
+
+void *xmalloc(size_t size);
+void *xzalloc(size_t size);
+
+/* The parts of the coreboot tables the modules under test look at. */
+#define CB_MEM_RAM		1
+#define CB_MEM_RESERVED		2
+#define CB_MEM_TABLE		16
+
+#define SYSINFO_MAX_MEM_RANGES	32
+
+struct memrange {
+	unsigned long long base;
+	unsigned long long size;
+	unsigned int type;
+};
+
+struct sysinfo_t {
+	int n_memranges;
+	struct memrange memrange[SYSINFO_MAX_MEM_RANGES];
+	uint32_t board_id;
+};
+
+extern struct sysinfo_t lib_sysinfo;
+
+uint64_t timer_hz(void);
+uint64_t timer_raw_value(void);
+uint64_t timer_us(uint64_t base);
+
+#endif /* __TESTS_INCLUDE_LIBPAYLOAD_H__ */
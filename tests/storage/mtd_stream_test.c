@@ -0,0 +1,226 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "base/container_of.h"
+#include "drivers/storage/mtd/stream.h"
+#include "harness.h"
+
+enum {
+	PageSize = 2048,
+	PagesPerBlock = 8,
+	BlockSize = PageSize * PagesPerBlock,
+	Blocks = 16,
+	BenchBlocks = 256
+};
+
+/* A NAND device backed by memory, counting what's asked of it. */
+typedef struct {
+	MtdDevCtrlr ctrlr;
+	MtdDev mtd;
+	uint8_t *data;
+	uint32_t bad_blocks;
+	int reads;
+	int isbad_calls;
+} RamNand;
+
+static int ram_read(MtdDev *mtd, uint64_t from, size_t len, size_t *retlen,
+		    unsigned char *buf)
+{
+	RamNand *nand = container_of(mtd, RamNand, mtd);
+
+	*retlen = 0;
+	if (from % PageSize || from + len > mtd->size)
+		return -EINVAL;
+	memcpy(buf, nand->data + from, len);
+	*retlen = len;
+	nand->reads++;
+	return 0;
+}
+
+static int ram_block_isbad(MtdDev *mtd, uint64_t ofs)
+{
+	RamNand *nand = container_of(mtd, RamNand, mtd);
+
+	nand->isbad_calls++;
+	return !!(nand->bad_blocks & (1 << (ofs / BlockSize)));
+}
+
+static int ram_update(MtdDevCtrlr *ctrlr)
+{
+	return 0;
+}
+
+static void ram_nand_init(RamNand *nand, int blocks)
+{
+	memset(nand, 0, sizeof(*nand));
+	nand->ctrlr.dev = &nand->mtd;
+	nand->ctrlr.update = &ram_update;
+	nand->mtd.size = (uint64_t)blocks * BlockSize;
+	nand->mtd.erasesize = BlockSize;
+	nand->mtd.writesize = PageSize;
+	nand->mtd.read = &ram_read;
+	nand->mtd.block_isbad = &ram_block_isbad;
+	nand->data = xmalloc(nand->mtd.size);
+	for (uint64_t i = 0; i < nand->mtd.size; i++)
+		nand->data[i] = i * 7 + i / 251;
+}
+
+static StreamOps *ram_nand_open(RamNand *nand, uint64_t offset,
+				uint64_t size)
+{
+	StreamCtrlr *ctrlr = new_mtd_stream(&nand->ctrlr);
+
+	return ctrlr->open(ctrlr, offset, size);
+}
+
+static void test_aligned(void)
+{
+	RamNand nand;
+	ram_nand_init(&nand, Blocks);
+	uint8_t *buf = xmalloc(3 * BlockSize);
+
+	StreamOps *stream = ram_nand_open(&nand, BlockSize, 4 * BlockSize);
+	CHECK(stream);
+	CHECK_EQ(stream->read(stream, 2 * PageSize, buf), 2 * PageSize);
+	CHECK_EQ(stream->read(stream, 3 * BlockSize - 2 * PageSize,
+			      buf + 2 * PageSize), 3 * BlockSize - 2 * PageSize);
+	CHECK(!memcmp(buf, nand.data + BlockSize, 3 * BlockSize));
+	// Whole pages go straight to the caller, a block at a time at most.
+	CHECK_EQ(nand.reads, 4);
+	stream->close(stream);
+
+	free(buf);
+	free(nand.data);
+}
+
+static void test_unaligned(void)
+{
+	static const uint32_t sizes[] = { 1, 100, 2047, 2049, 5000, 17, 30000 };
+	RamNand nand;
+	ram_nand_init(&nand, Blocks);
+	uint8_t *buf = xmalloc(Blocks * BlockSize);
+
+	StreamOps *stream = ram_nand_open(&nand, 0, Blocks * BlockSize);
+	CHECK(stream);
+	uint64_t pos = 0;
+	for (int i = 0; i < ARRAY_SIZE(sizes); i++) {
+		CHECK_EQ(stream->read(stream, sizes[i], buf + pos), sizes[i]);
+		pos += sizes[i];
+	}
+	CHECK(!memcmp(buf, nand.data, pos));
+	stream->close(stream);
+
+	free(buf);
+	free(nand.data);
+}
+
+static void test_small_reads_share_pages(void)
+{
+	RamNand nand;
+	ram_nand_init(&nand, Blocks);
+	uint8_t buf[PageSize * 2];
+
+	StreamOps *stream = ram_nand_open(&nand, 0, Blocks * BlockSize);
+	CHECK(stream);
+	for (int i = 0; i < sizeof(buf) / 16; i++)
+		CHECK_EQ(stream->read(stream, 16, buf + i * 16), 16);
+	CHECK(!memcmp(buf, nand.data, sizeof(buf)));
+	// Each page is only read once.
+	CHECK_EQ(nand.reads, 2);
+	stream->close(stream);
+
+	free(nand.data);
+}
+
+static void test_bad_blocks(void)
+{
+	RamNand nand;
+	ram_nand_init(&nand, Blocks);
+	nand.bad_blocks = (1 << 1) | (1 << 2);
+	uint8_t *buf = xmalloc(2 * BlockSize);
+
+	for (int pass = 0; pass < 2; pass++) {
+		StreamOps *stream = ram_nand_open(&nand, 0, 4 * BlockSize);
+		CHECK(stream);
+		CHECK_EQ(stream->read(stream, BlockSize - 10, buf),
+			 BlockSize - 10);
+		CHECK_EQ(stream->read(stream, BlockSize + 10,
+				      buf + BlockSize - 10), BlockSize + 10);
+		CHECK(!memcmp(buf, nand.data, BlockSize));
+		CHECK(!memcmp(buf + BlockSize, nand.data + 3 * BlockSize,
+			      BlockSize));
+		// Past the end, once the bad blocks are skipped.
+		CHECK_EQ(stream->read(stream, 1, buf), 0);
+		stream->close(stream);
+	}
+	// The second pass didn't have to ask the device.
+	CHECK_EQ(nand.isbad_calls, 4);
+
+	free(buf);
+	free(nand.data);
+}
+
+static void test_end_of_partition(void)
+{
+	RamNand nand;
+	ram_nand_init(&nand, Blocks);
+	uint8_t *buf = xmalloc(2 * BlockSize);
+
+	StreamOps *stream = ram_nand_open(&nand, 2 * BlockSize, 2 * BlockSize);
+	CHECK(stream);
+	CHECK_EQ(stream->read(stream, 2 * BlockSize - 3, buf),
+		 2 * BlockSize - 3);
+	CHECK_EQ(stream->read(stream, 3, buf + 2 * BlockSize - 3), 3);
+	CHECK(!memcmp(buf, nand.data + 2 * BlockSize, 2 * BlockSize));
+	CHECK_EQ(stream->read(stream, 1, buf), 0);
+	stream->close(stream);
+
+	free(buf);
+	free(nand.data);
+}
+
+HostTest host_tests[] = {
+	{ "aligned", &test_aligned },
+	{ "unaligned", &test_unaligned },
+	{ "small_reads_share_pages", &test_small_reads_share_pages },
+	{ "bad_blocks", &test_bad_blocks },
+	{ "end_of_partition", &test_end_of_partition },
+	{ NULL }
+};
+
+/* A kernel sized read which starts and ends partway through pages. */
+static void bench_read(uint64_t iterations)
+{
+	RamNand nand;
+	ram_nand_init(&nand, BenchBlocks);
+	uint8_t *buf = xmalloc(nand.mtd.size);
+
+	host_bench_start();
+	for (uint64_t i = 0; i < iterations; i++) {
+		StreamOps *stream = ram_nand_open(&nand, 0, nand.mtd.size);
+		host_bench_sink = stream->read(stream, 100, buf);
+		host_bench_sink += stream->read(stream, nand.mtd.size - 200,
+						buf + 100);
+		stream->close(stream);
+	}
+
+	free(buf);
+	free(nand.data);
+}
+
+HostBench host_benches[] = {
+	{ "read_4m", &bench_read, (uint64_t)BenchBlocks * BlockSize - 100 },
+	{ NULL }
+};
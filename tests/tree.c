@@ -0,0 +1,88 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <libpayload.h>
+
+#include "tree.h"
+
+DeviceTree *test_tree_new(void)
+{
+	DeviceTree *tree = xzalloc(sizeof(*tree));
+	FdtHeader *header = xzalloc(sizeof(*header));
+
+	header->magic = htobel(FdtMagic);
+	header->version = htobel(17);
+	header->last_compatible_version = htobel(16);
+	// dt_flatten() fills in the rest, but the reserve map goes here.
+	header->reserve_map_offset = htobel(sizeof(*header));
+
+	tree->header = header;
+	tree->header_size = sizeof(*header);
+	tree->root = xzalloc(sizeof(*tree->root));
+	tree->root->name = "";
+	return tree;
+}
+
+DeviceTree *test_tree_new_board(void)
+{
+	DeviceTree *tree = test_tree_new();
+	static char okay[] = "okay";
+	static char compat[] = "test,device\0test,generic";
+	static char last[] = "test,last";
+
+	dt_add_u32_prop(tree->root, "#address-cells", 2);
+	dt_add_u32_prop(tree->root, "#size-cells", 2);
+	dt_add_string_prop(tree->root, "model", "Host Test Board");
+
+	for (int bus = 0; bus < TestTreeBuses; bus++) {
+		char path[64];
+
+		snprintf(path, sizeof(path), "soc/bus@%d", bus);
+		DeviceTreeNode *bus_node = dt_find_node_by_path(
+			tree->root, path, NULL, NULL, 1);
+		dt_add_u32_prop(bus_node, "#address-cells", 1);
+		dt_add_u32_prop(bus_node, "#size-cells", 1);
+
+		for (int dev = 0; dev < TestTreeDevices; dev++) {
+			snprintf(path, sizeof(path), "device@%d", dev);
+			DeviceTreeNode *node = dt_find_node_by_path(
+				bus_node, path, NULL, NULL, 1);
+
+			u64 addr = 0x10000000 + bus * 0x100000 + dev * 0x1000;
+			u64 size = 0x1000;
+			dt_add_reg_prop(node, &addr, &size, 1, 1, 1);
+			dt_add_u32_prop(node, "interrupts", bus * 32 + dev);
+			dt_add_u32_prop(node, "phandle", bus * 256 + dev + 1);
+			dt_add_string_prop(node, "status", okay);
+			// New children go first, so this is found last.
+			if (bus == 0 && dev == 0)
+				dt_add_string_prop(node, "compatible", last);
+			else
+				dt_add_bin_prop(node, "compatible", compat,
+						sizeof(compat));
+		}
+	}
+
+	return tree;
+}
+
+void *test_tree_flatten(DeviceTree *tree, uint32_t *size)
+{
+	uint32_t flat_size = dt_flat_size(tree);
+	void *blob = xzalloc(flat_size);
+
+	dt_flatten(tree, blob);
+	if (size)
+		*size = flat_size;
+	return blob;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2016 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TESTS_TREE_H__
+#define __TESTS_TREE_H__
+
+#include <stdint.h>
+
+#include "base/device_tree.h"
+
+enum {
+	// The shape of test_tree_new_board()'s tree.
+	TestTreeBuses = 8,
+	TestTreeDevices = 24
+};
+
+// An empty tree with just a root node, ready for dt_flatten().
+DeviceTree *test_tree_new(void);
+
+/*
+ * A tree about the size of a real board's, with TestTreeBuses busses under
+ * /soc holding TestTreeDevices devices each. Only soc/bus@0/device@0, the last
+ * node a search comes to, is compatible with "test,last".
+ */
+DeviceTree *test_tree_new_board(void);
+
+// Flatten tree into a new buffer. *size is set if size isn't NULL.
+void *test_tree_flatten(DeviceTree *tree, uint32_t *size);
+
+#endif /* __TESTS_TREE_H__ */